@@ -0,0 +1,245 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// ips_mqtt_fields.cc author Zhinoo Zobairi
+// IPS options testing numeric MQTT header fields against a range.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "framework/cursor.h"
+#include "framework/ips_option.h"
+#include "framework/module.h"
+#include "framework/range.h"
+#include "hash/hash_key_operations.h"
+#include "profiler/profiler.h"
+#include "protocols/packet.h"
+
+#include "mqtt.h"
+
+using namespace snort;
+
+// The options only differ in the field they read and its range, so they
+// share one option and one module class; each still has its own api.
+struct MqttFieldInfo
+{
+    const char* name;
+    const char* help;
+    const char* range;
+    const char* param_help;
+};
+
+// Indexed by mqtt_field_t
+static const MqttFieldInfo mqtt_fields[] =
+{
+    { "mqtt_msgtype", "rule option to check the MQTT control packet type", "0:15",
+      "check if the packet type is in the given range" },
+
+    { "mqtt_qos", "rule option to check the QoS of an MQTT PUBLISH", "0:3",
+      "check if the PUBLISH QoS is in the given range" },
+
+    { "mqtt_flags", "rule option to check the MQTT fixed header flags (DUP, QoS, RETAIN)", "0:15",
+      "check if the low nibble of the first byte is in the given range" },
+
+    { "mqtt_remaining_len", "rule option to check the MQTT remaining length", "0:268435455",
+      "check if the remaining length is in the given range" },
+
+    { "mqtt_keepalive", "rule option to check the keep-alive of an MQTT CONNECT", "0:65535",
+      "check if the CONNECT keep-alive seconds are in the given range" },
+
+    { "mqtt_connack", "rule option to check the return code of an MQTT CONNACK", "0:255",
+      "check if the CONNACK return or reason code is in the given range" },
+};
+
+#define MQTT_FIELD_COUNT (sizeof(mqtt_fields) / sizeof(mqtt_fields[0]))
+
+static THREAD_LOCAL ProfileStats mqtt_field_prof[MQTT_FIELD_COUNT];
+
+//-------------------------------------------------------------------------
+// option
+//-------------------------------------------------------------------------
+
+class MqttFieldOption : public IpsOption
+{
+public:
+    MqttFieldOption(mqtt_field_t f, const RangeCheck& c) :
+        IpsOption(mqtt_fields[f].name), field(f), config(c) { }
+
+    uint32_t hash() const override;
+    bool operator==(const IpsOption&) const override;
+
+    EvalStatus eval(Cursor&, Packet*) override;
+
+private:
+    mqtt_field_t field;
+    RangeCheck config;
+};
+
+uint32_t MqttFieldOption::hash() const
+{
+    uint32_t a = config.op, b = config.min, c = config.max;
+
+    mix(a, b, c);
+    a += IpsOption::hash();
+    b += field;
+
+    finalize(a, b, c);
+    return c;
+}
+
+bool MqttFieldOption::operator==(const IpsOption& ips) const
+{
+    if (!IpsOption::operator==(ips))
+        return false;
+
+    const MqttFieldOption& rhs = static_cast<const MqttFieldOption&>(ips);
+    return field == rhs.field && config == rhs.config;
+}
+
+IpsOption::EvalStatus MqttFieldOption::eval(Cursor&, Packet* p)
+{
+    RuleProfile profile(mqtt_field_prof[field]);  // cppcheck-suppress unreadVariable
+
+    uint32_t value;
+    if (!get_mqtt_field(p, field, value))
+        return NO_MATCH;
+
+    return config.eval(value) ? MATCH : NO_MATCH;
+}
+
+//-------------------------------------------------------------------------
+// module
+//-------------------------------------------------------------------------
+
+#define FIELD_PARAMS(f) \
+    { { "~range", Parameter::PT_INTERVAL, mqtt_fields[f].range, nullptr, \
+        mqtt_fields[f].param_help }, \
+      { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr } }
+
+static const Parameter mqtt_field_params[MQTT_FIELD_COUNT][2] =
+{
+    FIELD_PARAMS(MQTT_FIELD__MSG_TYPE),
+    FIELD_PARAMS(MQTT_FIELD__QOS),
+    FIELD_PARAMS(MQTT_FIELD__FLAGS),
+    FIELD_PARAMS(MQTT_FIELD__REMAINING_LEN),
+    FIELD_PARAMS(MQTT_FIELD__KEEPALIVE),
+    FIELD_PARAMS(MQTT_FIELD__CONNACK_CODE),
+};
+
+class MqttFieldModule : public Module
+{
+public:
+    MqttFieldModule(mqtt_field_t f) :
+        Module(mqtt_fields[f].name, mqtt_fields[f].help, mqtt_field_params[f]), field(f) { }
+
+    bool begin(const char*, int, SnortConfig*) override;
+    bool set(const char*, Value&, SnortConfig*) override;
+
+    ProfileStats* get_profile() const override
+    { return &mqtt_field_prof[field]; }
+
+    Usage get_usage() const override
+    { return DETECT; }
+
+public:
+    mqtt_field_t field;
+    RangeCheck range;
+};
+
+bool MqttFieldModule::begin(const char*, int, SnortConfig*)
+{
+    range.init();
+    return true;
+}
+
+bool MqttFieldModule::set(const char*, Value& v, SnortConfig*)
+{
+    if (!v.is("~range"))
+        return false;
+
+    return range.validate(v.get_string(), mqtt_fields[field].range);
+}
+
+//-------------------------------------------------------------------------
+// api
+//-------------------------------------------------------------------------
+
+template<mqtt_field_t f>
+static Module* mod_ctor()
+{
+    return new MqttFieldModule(f);
+}
+
+static void mod_dtor(Module* m)
+{
+    delete m;
+}
+
+static IpsOption* opt_ctor(Module* m, IpsInfo&)
+{
+    MqttFieldModule* mod = (MqttFieldModule*)m;
+    return new MqttFieldOption(mod->field, mod->range);
+}
+
+static void opt_dtor(IpsOption* p)
+{
+    delete p;
+}
+
+#define FIELD_API(f) \
+    { \
+        { \
+            PT_IPS_OPTION, \
+            sizeof(IpsApi), \
+            IPSAPI_VERSION, \
+            0, \
+            API_RESERVED, \
+            API_OPTIONS, \
+            mqtt_fields[f].name, \
+            mqtt_fields[f].help, \
+            mod_ctor<f>, \
+            mod_dtor \
+        }, \
+        OPT_TYPE_DETECTION, \
+        0, PROTO_BIT__TCP, \
+        nullptr, \
+        nullptr, \
+        nullptr, \
+        nullptr, \
+        opt_ctor, \
+        opt_dtor, \
+        nullptr \
+    }
+
+static const IpsApi mqtt_field_apis[MQTT_FIELD_COUNT] =
+{
+    FIELD_API(MQTT_FIELD__MSG_TYPE),
+    FIELD_API(MQTT_FIELD__QOS),
+    FIELD_API(MQTT_FIELD__FLAGS),
+    FIELD_API(MQTT_FIELD__REMAINING_LEN),
+    FIELD_API(MQTT_FIELD__KEEPALIVE),
+    FIELD_API(MQTT_FIELD__CONNACK_CODE),
+};
+
+const BaseApi* ips_mqtt_msgtype = &mqtt_field_apis[MQTT_FIELD__MSG_TYPE].base;
+const BaseApi* ips_mqtt_qos = &mqtt_field_apis[MQTT_FIELD__QOS].base;
+const BaseApi* ips_mqtt_flags = &mqtt_field_apis[MQTT_FIELD__FLAGS].base;
+const BaseApi* ips_mqtt_remaining_len = &mqtt_field_apis[MQTT_FIELD__REMAINING_LEN].base;
+const BaseApi* ips_mqtt_keepalive = &mqtt_field_apis[MQTT_FIELD__KEEPALIVE].base;
+const BaseApi* ips_mqtt_connack = &mqtt_field_apis[MQTT_FIELD__CONNACK_CODE].base;
@@ -0,0 +1,266 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// ips_mqtt_payload_json.cc author Zhinoo Zobairi
+// IPS option setting the cursor to a JSON value in the PUBLISH payload.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "detection/ips_context.h"
+#include "framework/cursor.h"
+#include "framework/ips_option.h"
+#include "framework/module.h"
+#include "hash/hash_key_operations.h"
+#include "log/messages.h"
+#include "profiler/profiler.h"
+#include "protocols/packet.h"
+
+#include "mqtt.h"
+#include "mqtt_demand.h"
+#include "mqtt_json.h"
+
+using namespace snort;
+
+static const char* s_name = "mqtt_payload_json";
+
+//-------------------------------------------------------------------------
+// shared paths
+//-------------------------------------------------------------------------
+
+// Every mqtt_payload_json path of the rule set being loaded goes into this
+// table, compiled by verify() once all rules are parsed. Options keep it
+// alive, so a reload builds a new table while packet threads use the old one.
+static std::shared_ptr<MqttJsonPaths> loading_paths;
+
+// Spans of the last scan on this thread; every option of the rule set
+// reads its own path's entry, so a payload is scanned once per PDU
+struct PayloadJsonCache
+{
+    const MqttJsonPaths* paths;
+    uint64_t packet_number;
+    const uint8_t* payload;
+    std::vector<MqttJsonSpan> spans;
+};
+
+static THREAD_LOCAL PayloadJsonCache* payload_json_cache = nullptr;
+
+//-------------------------------------------------------------------------
+// mqtt_payload_json option
+//-------------------------------------------------------------------------
+
+static THREAD_LOCAL ProfileStats mqtt_payload_json_prof;
+
+class MqttPayloadJsonOption : public IpsOption
+{
+public:
+    MqttPayloadJsonOption(const std::string& s, const std::shared_ptr<MqttJsonPaths>& t) :
+        IpsOption(s_name), path(s), paths(t), id(t->add(s.c_str(), s.size())) { }
+
+    uint32_t hash() const override;
+    bool operator==(const IpsOption&) const override;
+
+    EvalStatus eval(Cursor&, Packet*) override;
+
+    CursorActionType get_cursor_type() const override
+    { return CAT_SET_OTHER; }
+
+private:
+    std::string path;
+    std::shared_ptr<MqttJsonPaths> paths;
+    unsigned id;
+};
+
+uint32_t MqttPayloadJsonOption::hash() const
+{
+    uint32_t a = IpsOption::hash(), b = path.size(), c = 0;
+
+    mix_str(a, b, c, path.c_str(), path.size());
+    finalize(a, b, c);
+
+    return c;
+}
+
+bool MqttPayloadJsonOption::operator==(const IpsOption& ips) const
+{
+    if (!IpsOption::operator==(ips))
+        return false;
+
+    const MqttPayloadJsonOption& rhs = static_cast<const MqttPayloadJsonOption&>(ips);
+    return path == rhs.path;
+}
+
+IpsOption::EvalStatus MqttPayloadJsonOption::eval(Cursor& c, Packet* p)
+{
+    RuleProfile profile(mqtt_payload_json_prof);  // cppcheck-suppress unreadVariable
+
+    InspectionBuffer b;
+    if (!paths->is_compiled() || !get_buf_mqtt_payload(p, b))
+        return NO_MATCH;
+
+    if (!payload_json_cache)
+        payload_json_cache = new PayloadJsonCache { nullptr, 0, nullptr, { } };
+
+    PayloadJsonCache& cache = *payload_json_cache;
+    uint64_t packet_number = p->context ? p->context->packet_number : 0;
+
+    if (cache.paths != paths.get() || cache.packet_number != packet_number ||
+        cache.payload != b.data)
+    {
+        cache.paths = paths.get();
+        cache.packet_number = packet_number;
+        cache.payload = b.data;
+        cache.spans.resize(paths->size());
+
+        mqtt_stats.json_scans++;
+        if (!paths->scan(b.data, b.len, cache.spans.data()))
+            mqtt_stats.json_malformed++;
+    }
+
+    const MqttJsonSpan& span = cache.spans[id];
+    if (!span.found)
+        return NO_MATCH;
+
+    c.set(s_name, b.data + span.offset, span.len);
+    return MATCH;
+}
+
+//-------------------------------------------------------------------------
+// module
+//-------------------------------------------------------------------------
+
+static const Parameter s_params[] =
+{
+    { "~path", Parameter::PT_STRING, nullptr, nullptr,
+      "JSON key path such as $.cmd, $.fw.url or $.readings[0].value" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
+#define s_help \
+    "rule option to set the cursor to a JSON value in the MQTT PUBLISH payload"
+
+class MqttPayloadJsonModule : public Module
+{
+public:
+    MqttPayloadJsonModule() : Module(s_name, s_help, s_params) { }
+
+    bool set(const char*, Value&, SnortConfig*) override;
+
+    ProfileStats* get_profile() const override
+    { return &mqtt_payload_json_prof; }
+
+    Usage get_usage() const override
+    { return DETECT; }
+
+public:
+    std::string path;
+};
+
+bool MqttPayloadJsonModule::set(const char*, Value& v, SnortConfig*)
+{
+    if (!v.is("~path"))
+        return false;
+
+    path = v.get_string();
+
+    if (!MqttJsonPaths::valid_path(path.c_str(), path.size()))
+    {
+        ParseError("%s: invalid JSON path '%s'", s_name, path.c_str());
+        return false;
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------------
+// api
+//-------------------------------------------------------------------------
+
+static Module* mod_ctor()
+{
+    return new MqttPayloadJsonModule;
+}
+
+static void mod_dtor(Module* m)
+{
+    delete m;
+}
+
+static IpsOption* opt_ctor(Module* m, IpsInfo&)
+{
+    MqttPayloadJsonModule* mod = (MqttPayloadJsonModule*)m;
+
+    if (!loading_paths)
+        loading_paths = std::make_shared<MqttJsonPaths>();
+
+    mqtt_add_demand(MQTT_DEMAND__PUBLISH);
+    return new MqttPayloadJsonOption(mod->path, loading_paths);
+}
+
+static void opt_dtor(IpsOption* p)
+{
+    mqtt_remove_demand(MQTT_DEMAND__PUBLISH);
+    delete p;
+}
+
+static void opt_tterm(const SnortConfig*)
+{
+    delete payload_json_cache;
+    payload_json_cache = nullptr;
+}
+
+static void opt_verify(const SnortConfig*)
+{
+    if (!loading_paths)
+        return;
+
+    loading_paths->compile();
+    loading_paths.reset();
+}
+
+static const IpsApi ips_api =
+{
+    {
+        PT_IPS_OPTION,
+        sizeof(IpsApi),
+        IPSAPI_VERSION,
+        0,
+        API_RESERVED,
+        API_OPTIONS,
+        s_name,
+        s_help,
+        mod_ctor,
+        mod_dtor
+    },
+    OPT_TYPE_DETECTION,
+    0, PROTO_BIT__TCP,
+    nullptr,
+    nullptr,
+    nullptr,
+    opt_tterm,
+    opt_ctor,
+    opt_dtor,
+    opt_verify
+};
+
+const BaseApi* ips_mqtt_payload_json = &ips_api.base;
@@ -0,0 +1,158 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// ips_mqtt_properties.cc author Zhinoo Zobairi
+// IPS option to set cursor to the raw MQTT 5 property block.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "framework/cursor.h"
+#include "framework/ips_option.h"
+#include "framework/module.h"
+#include "hash/hash_key_operations.h"
+#include "profiler/profiler.h"
+#include "protocols/packet.h"
+
+#include "mqtt.h"
+#include "mqtt_demand.h"
+
+using namespace snort;
+
+static const char* s_name = "mqtt_properties";
+
+//-------------------------------------------------------------------------
+// mqtt_properties option
+//-------------------------------------------------------------------------
+
+static THREAD_LOCAL ProfileStats mqtt_properties_prof;
+
+class MqttPropertiesOption : public IpsOption
+{
+public:
+    MqttPropertiesOption() : IpsOption(s_name) { }
+
+    uint32_t hash() const override;
+    bool operator==(const IpsOption&) const override;
+
+    EvalStatus eval(Cursor&, Packet*) override;
+
+    CursorActionType get_cursor_type() const override
+    { return CAT_SET_FAST_PATTERN; }
+};
+
+uint32_t MqttPropertiesOption::hash() const
+{
+    uint32_t a = IpsOption::hash(), b = 0, c = 0;
+
+    mix(a, b, c);
+    finalize(a, b, c);
+
+    return c;
+}
+
+bool MqttPropertiesOption::operator==(const IpsOption& ips) const
+{
+    return IpsOption::operator==(ips);
+}
+
+IpsOption::EvalStatus MqttPropertiesOption::eval(Cursor& c, Packet* p)
+{
+    RuleProfile profile(mqtt_properties_prof);  // cppcheck-suppress unreadVariable
+
+    InspectionBuffer b;
+    if (!get_buf_mqtt_properties(p, b))
+        return NO_MATCH;
+
+    c.set(s_name, b.data, b.len);
+
+    return MATCH;
+}
+
+//-------------------------------------------------------------------------
+// module
+//-------------------------------------------------------------------------
+
+#define s_help \
+    "rule option to set cursor to the MQTT 5 property block"
+
+class MqttPropertiesModule : public Module
+{
+public:
+    MqttPropertiesModule() : Module(s_name, s_help) { }
+
+    ProfileStats* get_profile() const override
+    { return &mqtt_properties_prof; }
+
+    Usage get_usage() const override
+    { return DETECT; }
+};
+
+//-------------------------------------------------------------------------
+// api
+//-------------------------------------------------------------------------
+
+static Module* mod_ctor()
+{
+    return new MqttPropertiesModule;
+}
+
+static void mod_dtor(Module* m)
+{
+    delete m;
+}
+
+static IpsOption* opt_ctor(Module*, IpsInfo&)
+{
+    mqtt_add_demand(MQTT_DEMAND__PUBLISH);
+    return new MqttPropertiesOption;
+}
+
+static void opt_dtor(IpsOption* p)
+{
+    mqtt_remove_demand(MQTT_DEMAND__PUBLISH);
+    delete p;
+}
+
+static const IpsApi ips_api =
+{
+    {
+        PT_IPS_OPTION,
+        sizeof(IpsApi),
+        IPSAPI_VERSION,
+        0,
+        API_RESERVED,
+        API_OPTIONS,
+        s_name,
+        s_help,
+        mod_ctor,
+        mod_dtor
+    },
+    OPT_TYPE_DETECTION,
+    0, PROTO_BIT__TCP,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    opt_ctor,
+    opt_dtor,
+    nullptr
+};
+
+const BaseApi* ips_mqtt_properties = &ips_api.base;
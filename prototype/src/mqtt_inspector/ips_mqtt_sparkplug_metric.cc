@@ -0,0 +1,276 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// ips_mqtt_sparkplug_metric.cc author Zhinoo Zobairi
+// IPS option testing the name, datatype and value of Sparkplug B metrics.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstring>
+#include <string>
+
+#include "framework/cursor.h"
+#include "framework/ips_option.h"
+#include "framework/module.h"
+#include "framework/range.h"
+#include "hash/hash_key_operations.h"
+#include "profiler/profiler.h"
+#include "protocols/packet.h"
+
+#include "mqtt.h"
+#include "mqtt_demand.h"
+
+using namespace snort;
+
+static const char* s_name = "mqtt_sparkplug_metric";
+
+// Doubles are exact up to 2^53
+#define s_value_range "-9007199254740992:9007199254740992"
+#define s_datatype_range "0:34"
+
+//-------------------------------------------------------------------------
+// mqtt_sparkplug_metric option
+//-------------------------------------------------------------------------
+
+static THREAD_LOCAL ProfileStats mqtt_sparkplug_metric_prof;
+
+struct SparkplugMetricConfig
+{
+    std::string name;               // Empty = any name
+    RangeCheck value;
+    RangeCheck datatype;
+    bool check_value;
+    bool check_datatype;
+};
+
+// Matches when one metric of the payload passes every test given
+class MqttSparkplugMetricOption : public IpsOption
+{
+public:
+    MqttSparkplugMetricOption(const SparkplugMetricConfig& c) :
+        IpsOption(s_name), config(c) { }
+
+    uint32_t hash() const override;
+    bool operator==(const IpsOption&) const override;
+
+    EvalStatus eval(Cursor&, Packet*) override;
+
+private:
+    SparkplugMetricConfig config;
+
+    bool match(const MqttSparkplugMetric&) const;
+};
+
+uint32_t MqttSparkplugMetricOption::hash() const
+{
+    uint32_t a = IpsOption::hash(), b = config.name.size(), c = 0;
+
+    mix_str(a, b, c, config.name.c_str(), config.name.size());
+
+    a += config.check_value ? config.value.op : 0;
+    b += config.check_value ? config.value.min : 0;
+    c += config.check_value ? config.value.max : 0;
+    mix(a, b, c);
+
+    a += config.check_datatype ? config.datatype.op : 0;
+    b += config.check_datatype ? config.datatype.min : 0;
+    c += config.check_datatype ? config.datatype.max : 0;
+    finalize(a, b, c);
+
+    return c;
+}
+
+bool MqttSparkplugMetricOption::operator==(const IpsOption& ips) const
+{
+    if (!IpsOption::operator==(ips))
+        return false;
+
+    const SparkplugMetricConfig& rhs = static_cast<const MqttSparkplugMetricOption&>(ips).config;
+
+    return config.name == rhs.name &&
+        config.check_value == rhs.check_value &&
+        (!config.check_value || config.value == rhs.value) &&
+        config.check_datatype == rhs.check_datatype &&
+        (!config.check_datatype || config.datatype == rhs.datatype);
+}
+
+bool MqttSparkplugMetricOption::match(const MqttSparkplugMetric& m) const
+{
+    if (!config.name.empty() && (!m.name || m.name_len != config.name.size() ||
+        memcmp(m.name, config.name.c_str(), m.name_len)))
+        return false;
+
+    if (config.check_datatype && !config.datatype.eval(m.datatype))
+        return false;
+
+    if (config.check_value)
+    {
+        if (m.is_null || (m.value_type != MQTT_SPARKPLUG_VALUE__INT &&
+            m.value_type != MQTT_SPARKPLUG_VALUE__DOUBLE))
+            return false;
+
+        if (!config.value.eval(m.as_int()))
+            return false;
+    }
+    return true;
+}
+
+IpsOption::EvalStatus MqttSparkplugMetricOption::eval(Cursor&, Packet* p)
+{
+    RuleProfile profile(mqtt_sparkplug_metric_prof);  // cppcheck-suppress unreadVariable
+
+    MqttSparkplugReader reader;
+    if (!get_mqtt_sparkplug(p, reader))
+        return NO_MATCH;
+
+    MqttSparkplugMetric m;
+    unsigned pos = 0;
+
+    while (reader.next(pos, m))
+    {
+        if (match(m))
+            return MATCH;
+    }
+    return NO_MATCH;
+}
+
+//-------------------------------------------------------------------------
+// module
+//-------------------------------------------------------------------------
+
+static const Parameter s_params[] =
+{
+    { "name", Parameter::PT_STRING, nullptr, nullptr,
+      "metric name, metrics sent with an alias only never match a name" },
+
+    { "value", Parameter::PT_INTERVAL, s_value_range, nullptr,
+      "numeric metric value, floating point values are truncated" },
+
+    { "datatype", Parameter::PT_INTERVAL, s_datatype_range, nullptr,
+      "Sparkplug datatype of the metric" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
+#define s_help \
+    "rule option to check the metrics of a Sparkplug B payload"
+
+class MqttSparkplugMetricModule : public Module
+{
+public:
+    MqttSparkplugMetricModule() : Module(s_name, s_help, s_params) { }
+
+    bool begin(const char*, int, SnortConfig*) override;
+    bool set(const char*, Value&, SnortConfig*) override;
+
+    ProfileStats* get_profile() const override
+    { return &mqtt_sparkplug_metric_prof; }
+
+    Usage get_usage() const override
+    { return DETECT; }
+
+public:
+    SparkplugMetricConfig config;
+};
+
+bool MqttSparkplugMetricModule::begin(const char*, int, SnortConfig*)
+{
+    config.name.clear();
+    config.value.init();
+    config.datatype.init();
+    config.check_value = false;
+    config.check_datatype = false;
+    return true;
+}
+
+bool MqttSparkplugMetricModule::set(const char*, Value& v, SnortConfig*)
+{
+    if (v.is("name"))
+        config.name = v.get_string();
+
+    else if (v.is("value"))
+    {
+        config.check_value = true;
+        return config.value.validate(v.get_string(), s_value_range);
+    }
+    else if (v.is("datatype"))
+    {
+        config.check_datatype = true;
+        return config.datatype.validate(v.get_string(), s_datatype_range);
+    }
+    else
+        return false;
+
+    return true;
+}
+
+//-------------------------------------------------------------------------
+// api
+//-------------------------------------------------------------------------
+
+static Module* mod_ctor()
+{
+    return new MqttSparkplugMetricModule;
+}
+
+static void mod_dtor(Module* m)
+{
+    delete m;
+}
+
+static IpsOption* opt_ctor(Module* m, IpsInfo&)
+{
+    MqttSparkplugMetricModule* mod = (MqttSparkplugMetricModule*)m;
+    mqtt_add_demand(MQTT_DEMAND__PUBLISH | MQTT_DEMAND__SPARKPLUG);
+    return new MqttSparkplugMetricOption(mod->config);
+}
+
+static void opt_dtor(IpsOption* p)
+{
+    mqtt_remove_demand(MQTT_DEMAND__PUBLISH | MQTT_DEMAND__SPARKPLUG);
+    delete p;
+}
+
+static const IpsApi ips_api =
+{
+    {
+        PT_IPS_OPTION,
+        sizeof(IpsApi),
+        IPSAPI_VERSION,
+        0,
+        API_RESERVED,
+        API_OPTIONS,
+        s_name,
+        s_help,
+        mod_ctor,
+        mod_dtor
+    },
+    OPT_TYPE_DETECTION,
+    0, PROTO_BIT__TCP,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    opt_ctor,
+    opt_dtor,
+    nullptr
+};
+
+const BaseApi* ips_mqtt_sparkplug_metric = &ips_api.base;
@@ -0,0 +1,226 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// ips_mqtt_sparkplug_name.cc author Zhinoo Zobairi
+// IPS option to set cursor to each metric name of a Sparkplug B payload.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "framework/cursor.h"
+#include "framework/ips_option.h"
+#include "framework/module.h"
+#include "hash/hash_key_operations.h"
+#include "profiler/profiler.h"
+#include "protocols/packet.h"
+
+#include "mqtt.h"
+#include "mqtt_demand.h"
+
+using namespace snort;
+
+static const char* s_name = "mqtt_sparkplug_name";
+
+//-------------------------------------------------------------------------
+// mqtt_sparkplug_name option
+//-------------------------------------------------------------------------
+
+static THREAD_LOCAL ProfileStats mqtt_sparkplug_name_prof;
+
+// Metric the option sets the cursor to. When the rest of the rule fails on
+// one name, retry() moves on and detection evaluates the option again.
+// Metrics sent with an alias only have no name and are skipped. Like
+// mqtt_sub_topic, the position lives in the cursor of the option's node.
+class SparkplugNameIter : public CursorData
+{
+public:
+    SparkplugNameIter() : CursorData(id) { }
+
+    CursorData* clone() override
+    { return new SparkplugNameIter(*this); }
+
+    static void init()
+    { id = create_cursor_data_id(); }
+
+    static unsigned id;
+
+    unsigned next = 0;              // Payload offset to search from on the next eval()
+    bool more = false;              // Payload left after the current metric
+    bool retrying = false;          // Set by retry(), a copy from an outer node is not
+};
+
+unsigned SparkplugNameIter::id = 0;
+
+class MqttSparkplugNameOption : public IpsOption
+{
+public:
+    MqttSparkplugNameOption() : IpsOption(s_name) { }
+
+    uint32_t hash() const override;
+    bool operator==(const IpsOption&) const override;
+
+    EvalStatus eval(Cursor&, Packet*) override;
+    bool retry(Cursor&) override;
+
+    // Many buffers per PDU, so not usable as a fast pattern
+    CursorActionType get_cursor_type() const override
+    { return CAT_SET_OTHER; }
+};
+
+uint32_t MqttSparkplugNameOption::hash() const
+{
+    uint32_t a = IpsOption::hash(), b = 0, c = 0;
+
+    mix(a, b, c);
+    finalize(a, b, c);
+
+    return c;
+}
+
+bool MqttSparkplugNameOption::operator==(const IpsOption& ips) const
+{
+    return IpsOption::operator==(ips);
+}
+
+IpsOption::EvalStatus MqttSparkplugNameOption::eval(Cursor& c, Packet* p)
+{
+    RuleProfile profile(mqtt_sparkplug_name_prof);  // cppcheck-suppress unreadVariable
+
+    SparkplugNameIter* it = static_cast<SparkplugNameIter*>(c.get_data(SparkplugNameIter::id));
+    unsigned pos = 0;
+
+    if (it && it->retrying)
+    {
+        pos = it->next;
+        it->retrying = false;
+    }
+    else
+    {
+        it = new SparkplugNameIter;
+        c.set_data(it);
+    }
+
+    it->more = false;
+
+    MqttSparkplugReader reader;
+    if (!get_mqtt_sparkplug(p, reader))
+        return NO_MATCH;
+
+    MqttSparkplugMetric m;
+    while (reader.next(pos, m))
+    {
+        if (!m.name)
+            continue;
+
+        it->next = pos;
+        it->more = true;
+        c.set(s_name, m.name, m.name_len);
+        return MATCH;
+    }
+
+    return NO_MATCH;
+}
+
+bool MqttSparkplugNameOption::retry(Cursor& c)
+{
+    SparkplugNameIter* it = static_cast<SparkplugNameIter*>(c.get_data(SparkplugNameIter::id));
+
+    if (!it || !it->more)
+        return false;
+
+    it->retrying = true;
+    return true;
+}
+
+//-------------------------------------------------------------------------
+// module
+//-------------------------------------------------------------------------
+
+#define s_help \
+    "rule option to set cursor to each metric name of a Sparkplug B payload in turn"
+
+class MqttSparkplugNameModule : public Module
+{
+public:
+    MqttSparkplugNameModule() : Module(s_name, s_help) { }
+
+    ProfileStats* get_profile() const override
+    { return &mqtt_sparkplug_name_prof; }
+
+    Usage get_usage() const override
+    { return DETECT; }
+};
+
+//-------------------------------------------------------------------------
+// api
+//-------------------------------------------------------------------------
+
+static Module* mod_ctor()
+{
+    return new MqttSparkplugNameModule;
+}
+
+static void mod_dtor(Module* m)
+{
+    delete m;
+}
+
+static void opt_pinit(const SnortConfig*)
+{
+    SparkplugNameIter::init();
+}
+
+static IpsOption* opt_ctor(Module*, IpsInfo&)
+{
+    mqtt_add_demand(MQTT_DEMAND__PUBLISH | MQTT_DEMAND__SPARKPLUG);
+    return new MqttSparkplugNameOption;
+}
+
+static void opt_dtor(IpsOption* p)
+{
+    mqtt_remove_demand(MQTT_DEMAND__PUBLISH | MQTT_DEMAND__SPARKPLUG);
+    delete p;
+}
+
+static const IpsApi ips_api =
+{
+    {
+        PT_IPS_OPTION,
+        sizeof(IpsApi),
+        IPSAPI_VERSION,
+        0,
+        API_RESERVED,
+        API_OPTIONS,
+        s_name,
+        s_help,
+        mod_ctor,
+        mod_dtor
+    },
+    OPT_TYPE_DETECTION,
+    0, PROTO_BIT__TCP,
+    opt_pinit,
+    nullptr,
+    nullptr,
+    nullptr,
+    opt_ctor,
+    opt_dtor,
+    nullptr
+};
+
+const BaseApi* ips_mqtt_sparkplug_name = &ips_api.base;
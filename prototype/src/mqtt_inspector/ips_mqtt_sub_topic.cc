@@ -0,0 +1,216 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// ips_mqtt_sub_topic.cc author Zhinoo Zobairi
+// IPS option to set cursor to each topic filter of SUBSCRIBE and UNSUBSCRIBE packets.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "framework/cursor.h"
+#include "framework/ips_option.h"
+#include "framework/module.h"
+#include "hash/hash_key_operations.h"
+#include "profiler/profiler.h"
+#include "protocols/packet.h"
+
+#include "mqtt.h"
+
+using namespace snort;
+
+static const char* s_name = "mqtt_sub_topic";
+
+//-------------------------------------------------------------------------
+// mqtt_sub_topic option
+//-------------------------------------------------------------------------
+
+static THREAD_LOCAL ProfileStats mqtt_sub_topic_prof;
+
+// Filter the option sets the cursor to. When the rest of the rule fails on
+// one filter, retry() moves on and detection evaluates the option again.
+// The position lives in the cursor of the option's own detection node, so
+// two of these options in one rule keep their own place, and a cursor
+// never outlives its packet.
+class SubTopicIter : public CursorData
+{
+public:
+    SubTopicIter() : CursorData(id) { }
+
+    CursorData* clone() override
+    { return new SubTopicIter(*this); }
+
+    static void init()
+    { id = create_cursor_data_id(); }
+
+    static unsigned id;
+
+    unsigned next = 0;              // Filter for the next eval()
+    unsigned count = 0;
+    bool retrying = false;          // Set by retry(), a copy from an outer node is not
+};
+
+unsigned SubTopicIter::id = 0;
+
+class MqttSubTopicOption : public IpsOption
+{
+public:
+    MqttSubTopicOption() : IpsOption(s_name) { }
+
+    uint32_t hash() const override;
+    bool operator==(const IpsOption&) const override;
+
+    EvalStatus eval(Cursor&, Packet*) override;
+    bool retry(Cursor&) override;
+
+    // Many buffers per PDU, so not usable as a fast pattern
+    CursorActionType get_cursor_type() const override
+    { return CAT_SET_OTHER; }
+};
+
+uint32_t MqttSubTopicOption::hash() const
+{
+    uint32_t a = IpsOption::hash(), b = 0, c = 0;
+
+    mix(a, b, c);
+    finalize(a, b, c);
+
+    return c;
+}
+
+bool MqttSubTopicOption::operator==(const IpsOption& ips) const
+{
+    return IpsOption::operator==(ips);
+}
+
+IpsOption::EvalStatus MqttSubTopicOption::eval(Cursor& c, Packet* p)
+{
+    RuleProfile profile(mqtt_sub_topic_prof);  // cppcheck-suppress unreadVariable
+
+    SubTopicIter* it = static_cast<SubTopicIter*>(c.get_data(SubTopicIter::id));
+    unsigned index = 0;
+
+    if (it && it->retrying)
+    {
+        index = it->next;
+        it->retrying = false;
+    }
+    else
+    {
+        it = new SubTopicIter;
+        c.set_data(it);
+    }
+
+    it->count = get_mqtt_sub_topic_count(p);
+    it->next = it->count;
+
+    InspectionBuffer b;
+    if (!get_buf_mqtt_sub_topic(p, index, b))
+        return NO_MATCH;
+
+    it->next = index + 1;
+    c.set(s_name, b.data, b.len);
+
+    return MATCH;
+}
+
+bool MqttSubTopicOption::retry(Cursor& c)
+{
+    SubTopicIter* it = static_cast<SubTopicIter*>(c.get_data(SubTopicIter::id));
+
+    if (!it || it->next >= it->count)
+        return false;
+
+    it->retrying = true;
+    return true;
+}
+
+//-------------------------------------------------------------------------
+// module
+//-------------------------------------------------------------------------
+
+#define s_help \
+    "rule option to set cursor to each MQTT SUBSCRIBE/UNSUBSCRIBE topic filter in turn"
+
+class MqttSubTopicModule : public Module
+{
+public:
+    MqttSubTopicModule() : Module(s_name, s_help) { }
+
+    ProfileStats* get_profile() const override
+    { return &mqtt_sub_topic_prof; }
+
+    Usage get_usage() const override
+    { return DETECT; }
+};
+
+//-------------------------------------------------------------------------
+// api
+//-------------------------------------------------------------------------
+
+static Module* mod_ctor()
+{
+    return new MqttSubTopicModule;
+}
+
+static void mod_dtor(Module* m)
+{
+    delete m;
+}
+
+static void opt_pinit(const SnortConfig*)
+{
+    SubTopicIter::init();
+}
+
+static IpsOption* opt_ctor(Module*, IpsInfo&)
+{
+    return new MqttSubTopicOption;
+}
+
+static void opt_dtor(IpsOption* p)
+{
+    delete p;
+}
+
+static const IpsApi ips_api =
+{
+    {
+        PT_IPS_OPTION,
+        sizeof(IpsApi),
+        IPSAPI_VERSION,
+        0,
+        API_RESERVED,
+        API_OPTIONS,
+        s_name,
+        s_help,
+        mod_ctor,
+        mod_dtor
+    },
+    OPT_TYPE_DETECTION,
+    0, PROTO_BIT__TCP,
+    opt_pinit,
+    nullptr,
+    nullptr,
+    nullptr,
+    opt_ctor,
+    opt_dtor,
+    nullptr
+};
+
+const BaseApi* ips_mqtt_sub_topic = &ips_api.base;
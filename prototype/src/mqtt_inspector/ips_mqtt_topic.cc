@@ -31,6 +31,7 @@
 #include "protocols/packet.h"
 
 #include "mqtt.h"
+#include "mqtt_demand.h"
 
 using namespace snort;
 
@@ -119,11 +120,13 @@ static void mod_dtor(Module* m)
 
 static IpsOption* opt_ctor(Module*, IpsInfo&)
 {
+    mqtt_add_demand(MQTT_DEMAND__PUBLISH);
     return new MqttTopicOption;
 }
 
 static void opt_dtor(IpsOption* p)
 {
+    mqtt_remove_demand(MQTT_DEMAND__PUBLISH);
     delete p;
 }
 
@@ -0,0 +1,264 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// ips_mqtt_topic_filter.cc author Zhinoo Zobairi
+// IPS option matching the PUBLISH topic against an MQTT topic filter.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "detection/ips_context.h"
+#include "framework/cursor.h"
+#include "framework/ips_option.h"
+#include "framework/module.h"
+#include "hash/hash_key_operations.h"
+#include "log/messages.h"
+#include "profiler/profiler.h"
+#include "protocols/packet.h"
+
+#include "mqtt.h"
+#include "mqtt_demand.h"
+#include "mqtt_topic_trie.h"
+
+using namespace snort;
+
+static const char* s_name = "mqtt_topic_filter";
+
+//-------------------------------------------------------------------------
+// shared trie
+//-------------------------------------------------------------------------
+
+// Every mqtt_topic_filter of the rule set being loaded goes into this trie,
+// compiled by verify() once all rules are parsed. Options keep it alive, so
+// a reload builds a new trie while packet threads still use the old one.
+static std::shared_ptr<MqttTopicTrie> loading_trie;
+
+// Result of the last walk on this thread; every option of the rule set
+// reads its own filter's entry, so a topic is walked once per PDU. A filter
+// matched the current topic when its stamp equals the generation, so a new
+// PDU costs a counter increment rather than clearing an entry per filter.
+struct TopicFilterCache
+{
+    const MqttTopicTrie* trie;
+    uint64_t packet_number;
+    const uint8_t* topic;
+    uint32_t generation;
+    std::vector<uint32_t> stamps;
+};
+
+static THREAD_LOCAL TopicFilterCache* topic_filter_cache = nullptr;
+
+//-------------------------------------------------------------------------
+// mqtt_topic_filter option
+//-------------------------------------------------------------------------
+
+static THREAD_LOCAL ProfileStats mqtt_topic_filter_prof;
+
+class MqttTopicFilterOption : public IpsOption
+{
+public:
+    MqttTopicFilterOption(const std::string& f, const std::shared_ptr<MqttTopicTrie>& t) :
+        IpsOption(s_name), filter(f), trie(t), id(t->add(f.c_str(), f.size())) { }
+
+    uint32_t hash() const override;
+    bool operator==(const IpsOption&) const override;
+
+    EvalStatus eval(Cursor&, Packet*) override;
+
+private:
+    std::string filter;
+    std::shared_ptr<MqttTopicTrie> trie;
+    unsigned id;
+};
+
+uint32_t MqttTopicFilterOption::hash() const
+{
+    uint32_t a = IpsOption::hash(), b = filter.size(), c = 0;
+
+    mix_str(a, b, c, filter.c_str(), filter.size());
+    finalize(a, b, c);
+
+    return c;
+}
+
+bool MqttTopicFilterOption::operator==(const IpsOption& ips) const
+{
+    if (!IpsOption::operator==(ips))
+        return false;
+
+    const MqttTopicFilterOption& rhs = static_cast<const MqttTopicFilterOption&>(ips);
+    return filter == rhs.filter;
+}
+
+IpsOption::EvalStatus MqttTopicFilterOption::eval(Cursor&, Packet* p)
+{
+    RuleProfile profile(mqtt_topic_filter_prof);  // cppcheck-suppress unreadVariable
+
+    InspectionBuffer b;
+    if (!trie->is_compiled() || !get_buf_mqtt_topic(p, b))
+        return NO_MATCH;
+
+    if (!topic_filter_cache)
+        topic_filter_cache = new TopicFilterCache { nullptr, 0, nullptr, 0, { } };
+
+    TopicFilterCache& cache = *topic_filter_cache;
+    uint64_t packet_number = p->context ? p->context->packet_number : 0;
+
+    if (cache.trie != trie.get() || cache.packet_number != packet_number ||
+        cache.topic != b.data)
+    {
+        // Stamps start over for a new trie and when the generation wraps
+        if (cache.trie != trie.get() || ++cache.generation == 0)
+        {
+            cache.stamps.assign(trie->size(), 0);
+            cache.generation = 1;
+        }
+
+        cache.trie = trie.get();
+        cache.packet_number = packet_number;
+        cache.topic = b.data;
+        trie->match(b.data, b.len, cache.stamps.data(), cache.generation);
+    }
+
+    return cache.stamps[id] == cache.generation ? MATCH : NO_MATCH;
+}
+
+//-------------------------------------------------------------------------
+// module
+//-------------------------------------------------------------------------
+
+static const Parameter s_params[] =
+{
+    { "~filter", Parameter::PT_STRING, nullptr, nullptr,
+      "MQTT topic filter, '+' matches one level and a trailing '#' any number" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
+#define s_help \
+    "rule option to match the MQTT PUBLISH topic against a topic filter"
+
+class MqttTopicFilterModule : public Module
+{
+public:
+    MqttTopicFilterModule() : Module(s_name, s_help, s_params) { }
+
+    bool set(const char*, Value&, SnortConfig*) override;
+
+    ProfileStats* get_profile() const override
+    { return &mqtt_topic_filter_prof; }
+
+    Usage get_usage() const override
+    { return DETECT; }
+
+public:
+    std::string filter;
+};
+
+bool MqttTopicFilterModule::set(const char*, Value& v, SnortConfig*)
+{
+    if (!v.is("~filter"))
+        return false;
+
+    filter = v.get_string();
+
+    if (!MqttTopicTrie::valid_filter(filter.c_str(), filter.size()))
+    {
+        ParseError("%s: invalid topic filter '%s'", s_name, filter.c_str());
+        return false;
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------------
+// api
+//-------------------------------------------------------------------------
+
+static Module* mod_ctor()
+{
+    return new MqttTopicFilterModule;
+}
+
+static void mod_dtor(Module* m)
+{
+    delete m;
+}
+
+static IpsOption* opt_ctor(Module* m, IpsInfo&)
+{
+    MqttTopicFilterModule* mod = (MqttTopicFilterModule*)m;
+
+    if (!loading_trie)
+        loading_trie = std::make_shared<MqttTopicTrie>();
+
+    mqtt_add_demand(MQTT_DEMAND__PUBLISH);
+    return new MqttTopicFilterOption(mod->filter, loading_trie);
+}
+
+static void opt_dtor(IpsOption* p)
+{
+    mqtt_remove_demand(MQTT_DEMAND__PUBLISH);
+    delete p;
+}
+
+static void opt_tterm(const SnortConfig*)
+{
+    delete topic_filter_cache;
+    topic_filter_cache = nullptr;
+}
+
+static void opt_verify(const SnortConfig*)
+{
+    if (!loading_trie)
+        return;
+
+    loading_trie->compile();
+    loading_trie.reset();
+}
+
+static const IpsApi ips_api =
+{
+    {
+        PT_IPS_OPTION,
+        sizeof(IpsApi),
+        IPSAPI_VERSION,
+        0,
+        API_RESERVED,
+        API_OPTIONS,
+        s_name,
+        s_help,
+        mod_ctor,
+        mod_dtor
+    },
+    OPT_TYPE_DETECTION,
+    0, PROTO_BIT__TCP,
+    nullptr,
+    nullptr,
+    nullptr,
+    opt_tterm,
+    opt_ctor,
+    opt_dtor,
+    opt_verify
+};
+
+const BaseApi* ips_mqtt_topic_filter = &ips_api.base;
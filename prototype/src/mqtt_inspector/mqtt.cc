@@ -4,153 +4,281 @@
 
 #include "mqtt.h"
 
+#include <cmath>
 #include <cstring>
+#include <memory>
 #include <sys/time.h>
 
 #include "detection/detection_engine.h"
+#include "detection/ips_context.h"
 #include "framework/data_bus.h"
+#include "log/messages.h"
 #include "profiler/profiler.h"
 #include "protocols/packet.h"
+#include "stream/stream.h"
+#include "sfip/sf_ip.h"
 
+#include "mqtt_acl.h"
+#include "mqtt_cardinality.h"
+#include "mqtt_demand.h"
 #include "mqtt_events.h"
+#include "mqtt_heavy_hitters.h"
+#include "mqtt_inflate.h"
 #include "mqtt_module.h"
 #include "mqtt_paf.h"
+#include "mqtt_payload_profile.h"
+#include "mqtt_rate_limit.h"
+#include "mqtt_topic_table.h"
+#include "mqtt_utf8.h"
 
 using namespace snort;
 
 THREAD_LOCAL MqttStats mqtt_stats;
 
+// One wheel per packet thread holds the keep-alive deadline of every MQTT flow
+static THREAD_LOCAL MqttTimerWheel* mqtt_keepalive_wheel = nullptr;
+
+// Topic filters of the PDU being inspected; reused for every PDU on the thread
+static THREAD_LOCAL mqtt_filter_span_t* mqtt_filter_arena = nullptr;
+
+// Keep-alive deadlines are in seconds, a one second tick is plenty
+#define MQTT_KEEPALIVE_TICK_NS 1000000000ULL
+
+// Weight of the newest gap in the inter-arrival EWMA (same as TCP's SRTT gain)
+#define MQTT_IAT_EWMA_ALPHA 0.125
+
+// Time constant of the decayed publish and byte rates
+#define MQTT_RATE_TAU_NS 1e9
+
+// Smallest standard deviation assumed for the topic baselines
+#define MQTT_BASELINE_SIZE_FLOOR 1.0
+#define MQTT_BASELINE_INTERVAL_FLOOR_US 1000.0
+
 // Indices in the buffer array exposed by InspectApi
 // Must remain synchronized with mqtt_bufs
 enum MqttBufId
 {
     MQTT_TOPIC_BUFID = 1,
     MQTT_PAYLOAD_BUFID,
-    MQTT_CLIENT_ID_BUFID
+    MQTT_CLIENT_ID_BUFID,
+    MQTT_CONTENT_TYPE_BUFID,
+    MQTT_PROPERTIES_BUFID,
+    MQTT_SUB_TOPIC_BUFID,
+    MQTT_USERNAME_BUFID,
+    MQTT_WILL_TOPIC_BUFID,
+    MQTT_WILL_MESSAGE_BUFID,
+    MQTT_PAYLOAD_DECOMPRESSED_BUFID
 };
 
-// Helper function - parse PUBLISH packet header and return offset to variable header
-static int parse_mqtt_publish_header(Packet* p, uint8_t* packet_type, uint8_t* qos)
+static bool parse_publish_packet(Packet*, mqtt_session_data_t*, uint8_t version);
+
+// Fields of the PDU eval() just parsed. The pointers in it refer to this
+// packet's data, so nothing is re-parsed or copied for rule evaluation.
+static const mqtt_session_data_t* get_pdu_data(Packet* p)
 {
-    if (!p->is_full_pdu() || p->dsize < 2)
-        return -1;
-    
-    // Extract type and QoS from first byte
-    uint8_t first_byte = p->data[0];
-    *packet_type = first_byte >> 4; //0x30 (binary 00110000) >> 4 = 0x03 (binary 00000011) = PUBLISH and since it is a pointer, we dereference to put a value inside it
-    *qos = (first_byte >> 1) & 0x03; // QoS is a 2-bit value, on bits 1 and 2, I want them as a normal number 0–3. 0x03 means keep only the lowest two bits, zero out everything else.
-    
-    // Check if PUBLISH
-    if (*packet_type != 3)
-        return -1;
-    
-    // Skip remaining length bytes (1-4 bytes with bit 7 = continuation flag)
-    int offset = 1;
-    while (offset < 5 && offset < p->dsize) { // Remaining Length can be at most 4 bytes and it starts at index 1 and do not read past the end of the buffer Snort gave us
-        if ((p->data[offset++] & 0x80) == 0) // & 0x80 checks the top bit (bit 7). If it’s 0, this is the last Remaining Length byte → stop. If it’s 1, more bytes follow → continue
-            break;  // Last length byte
+    if (!p->flow || !p->is_full_pdu() || p->dsize < 2)
+        return nullptr;
+
+    MqttFlowData* mfd =
+        (MqttFlowData*)p->flow->get_flow_data(MqttFlowData::inspector_id);
+
+    if (!mfd)
+        return nullptr;
+
+    // A rule nobody registered for, such as one on the IBT_BODY buffer, still
+    // gets the PUBLISH fields; an alias is not resolved this late though
+    if (mfd->ssn_data.publish_deferred)
+    {
+        mfd->ssn_data.publish_deferred = 0;
+        parse_publish_packet(p, &mfd->ssn_data, mfd->protocol_version);
+        mqtt_stats.publish_parsed_late++;
     }
-    
-    return offset;  // Points to start of variable header
+
+    return &mfd->ssn_data;
 }
 
 bool get_buf_mqtt_topic(Packet* p, InspectionBuffer& b)
 {
-    uint8_t packet_type, qos;
-    int offset = parse_mqtt_publish_header(p, &packet_type, &qos);
-    if (offset < 0)
-        return false;
-    
-    // Read topic length (2 bytes, big-endian)
-    if (offset + 2 > p->dsize)
-        return false;
-    
-    uint16_t topic_len = (p->data[offset] << 8) | p->data[offset + 1];
-    offset += 2;
-    
-    // Validate and set buffer
-    if (offset + topic_len > p->dsize)
+    const mqtt_session_data_t* ssn = get_pdu_data(p);
+    if (!ssn || ssn->msg_type != 3 || !ssn->topic)
         return false;
     
-    b.data = p->data + offset;
-    b.len = topic_len;
+    b.data = ssn->topic;
+    b.len = ssn->topic_len;
     return true;
 }
 
 bool get_buf_mqtt_payload(Packet* p, InspectionBuffer& b)
 {
-    uint8_t packet_type, qos;
-    int offset = parse_mqtt_publish_header(p, &packet_type, &qos);
-    if (offset < 0)
+    const mqtt_session_data_t* ssn = get_pdu_data(p);
+    if (!ssn || ssn->msg_type != 3 || !ssn->payload)
         return false;
     
-    // Read and skip topic length
-    if (offset + 2 > p->dsize)
+    b.data = ssn->payload;
+    b.len = ssn->payload_len;
+    return true;
+}
+
+// Null unless decompression is enabled; the owner is the inspector that
+// made this, the topic table and the heavy hitters, so a reloaded
+// inspector's tterm() leaves its successor's alone
+static THREAD_LOCAL MqttInflater* mqtt_inflater = nullptr;
+static THREAD_LOCAL const void* mqtt_thread_owner = nullptr;
+
+// Demand of the rules, subscribers and detectors when the thread started,
+// given to each flow it opens
+static THREAD_LOCAL uint8_t mqtt_thread_demand = MQTT_DEMAND__ALL;
+
+// Inflated at most once per PDU, on the first rule that asks
+bool get_buf_mqtt_payload_decompressed(Packet* p, InspectionBuffer& b)
+{
+    const mqtt_session_data_t* ssn = get_pdu_data(p);
+    if (!mqtt_inflater || !ssn || ssn->msg_type != 3 || !ssn->payload)
         return false;
-    
-    uint16_t topic_len = (p->data[offset] << 8) | p->data[offset + 1];
-    offset += 2 + topic_len;
-    
-    // Skip packet ID if QoS > 0
-    if (qos > 0)
-        offset += 2;
-    
-    // Validate and set buffer to remaining bytes
-    if (offset >= p->dsize)
+
+    const uint8_t* out;
+    unsigned out_len;
+    uint64_t packet_number = p->context ? p->context->packet_number : 0;
+
+    if (!mqtt_inflater->inflate(packet_number, ssn->payload, ssn->payload_len, out, out_len))
         return false;
-    
-    b.data = p->data + offset;
-    b.len = p->dsize - offset;
+
+    b.data = out;
+    b.len = out_len;
     return true;
 }
 
 bool get_buf_mqtt_client_id(Packet* p, InspectionBuffer& b)
 {
-    // 1. Safety check
-    if (!p->is_full_pdu() || p->dsize < 2)
+    // An empty client ID is valid MQTT (the broker assigns one), there is no buffer then
+    const mqtt_session_data_t* ssn = get_pdu_data(p);
+    if (!ssn || ssn->msg_type != 1 || !ssn->client_id)
         return false;
     
-    // 2. Parse packet type (must be CONNECT = 1)
-    uint8_t packet_type = p->data[0] >> 4; // If we didn't shift right by 4, and the byte was 0001 0000, the value would be 16 instead of 1.
-    if (packet_type != 1) // And we had to write `if (packet_type != 16)` here
+    b.data = ssn->client_id;
+    b.len = ssn->client_id_len;
+    return true;
+}
+
+bool get_buf_mqtt_username(Packet* p, InspectionBuffer& b)
+{
+    const mqtt_session_data_t* ssn = get_pdu_data(p);
+    if (!ssn || ssn->msg_type != 1 || !ssn->username)
         return false;
-    
-    // 3. Parse and skip remaining length bytes (1-4 bytes with bit 7 = continuation flag)
-    int offset = 1;
-    while (offset < 5 && offset < p->dsize) {
-        if ((p->data[offset++] & 0x80) == 0){ // "Is bit 7 zero?": Here we mask the 7th bit as continuation flag with 1000 0000 (0x80)
-            break; // keeping only bit 7 and zeroing out bits 0-6, if result of the AND operation is 0, it means the continuation flag was 0 and it was the last byte
-        }
-    }
-    
-    // 4. Skip Protocol Name (2-byte length + string "MQTT")
-    if (offset + 2 > p->dsize)
+
+    b.data = ssn->username;
+    b.len = ssn->username_len;
+    return true;
+}
+
+bool get_buf_mqtt_will_topic(Packet* p, InspectionBuffer& b)
+{
+    const mqtt_session_data_t* ssn = get_pdu_data(p);
+    if (!ssn || ssn->msg_type != 1 || !ssn->will_topic)
         return false;
-    //  shift-and-OR pattern:
-    uint16_t proto_len = (p->data[offset] << 8) | p->data[offset + 1]; // For the number 4: MSB occupying the first memory place: holds the big place values but they're all zero, no contribution – LSB occupying the first memory place: holds the small place values and the 4 bit is set, this is where the actual value lives. So even though MSB is "most significant" in terms of position/weight, for small numbers like 4, all the actual value is in the LSB!
-    offset += 2 + proto_len;
-    
-    // 5. Skip Version (1 byte) + Connect Flags (1 byte) + Keep Alive (2 bytes)
-    offset += 4;
-    
-    // 6. Read Client ID Length
-    if (offset + 2 > p->dsize)
+
+    b.data = ssn->will_topic;
+    b.len = ssn->will_topic_len;
+    return true;
+}
+
+bool get_buf_mqtt_will_message(Packet* p, InspectionBuffer& b)
+{
+    const mqtt_session_data_t* ssn = get_pdu_data(p);
+    if (!ssn || ssn->msg_type != 1 || !ssn->will_msg)
         return false;
-    //  shift-and-OR pattern:
-    uint16_t client_id_len = (p->data[offset] << 8) | p->data[offset + 1];
-    offset += 2;
-    
-    // 7. Handle empty client ID (length = 0)
-    //    This is valid MQTT - broker assigns ID. No buffer to extract.
-    if (client_id_len == 0)
+
+    b.data = ssn->will_msg;
+    b.len = ssn->will_msg_len;
+    return true;
+}
+
+bool get_buf_mqtt_content_type(Packet* p, InspectionBuffer& b)
+{
+    const mqtt_session_data_t* ssn = get_pdu_data(p);
+    const uint8_t* str;
+    uint16_t len;
+
+    if (!ssn || !ssn->props.get_string(MQTT_PROP__CONTENT_TYPE, str, len) || len == 0)
         return false;
-    
-    // 8. Validate and set buffer
-    if (offset + client_id_len > p->dsize)
+
+    b.data = str;
+    b.len = len;
+    return true;
+}
+
+bool get_buf_mqtt_properties(Packet* p, InspectionBuffer& b)
+{
+    const mqtt_session_data_t* ssn = get_pdu_data(p);
+    if (!ssn || !ssn->props.pdu || ssn->props.len == 0)
         return false;
-    
-    b.data = p->data + offset;
-    b.len = client_id_len;
+
+    b.data = ssn->props.pdu + ssn->props.start;
+    b.len = ssn->props.len;
+    return true;
+}
+
+unsigned get_mqtt_sub_topic_count(Packet* p)
+{
+    const mqtt_session_data_t* ssn = get_pdu_data(p);
+    return ssn ? ssn->filter_count : 0;
+}
+
+bool get_buf_mqtt_sub_topic(Packet* p, unsigned index, InspectionBuffer& b)
+{
+    const mqtt_session_data_t* ssn = get_pdu_data(p);
+    if (!ssn || index >= ssn->filter_count)
+        return false;
+
+    b.data = p->data + ssn->filters[index].offset;
+    b.len = ssn->filters[index].len;
+    return true;
+}
+
+// False when the PDU has no such field, so the option does not match
+bool get_mqtt_field(Packet* p, mqtt_field_t field, uint32_t& value)
+{
+    const mqtt_session_data_t* ssn = get_pdu_data(p);
+    if (!ssn)
+        return false;
+
+    switch (field)
+    {
+    case MQTT_FIELD__MSG_TYPE:
+        value = ssn->msg_type;
+        return true;
+
+    case MQTT_FIELD__QOS:
+        value = ssn->qos;
+        return ssn->msg_type == 3;
+
+    case MQTT_FIELD__FLAGS:
+        value = ssn->hdr_flags & 0x0F;
+        return true;
+
+    case MQTT_FIELD__REMAINING_LEN:
+        value = ssn->remaining_len;
+        return true;
+
+    case MQTT_FIELD__KEEPALIVE:
+        value = ssn->keep_alive;
+        return ssn->msg_type == 1 && ssn->protocol_version;
+
+    case MQTT_FIELD__CONNACK_CODE:
+        value = ssn->conack_return_code;
+        return ssn->msg_type == 2;
+    }
+    return false;
+}
+
+// Reader over the PUBLISH payload when eval() decoded it as Sparkplug B
+bool get_mqtt_sparkplug(Packet* p, MqttSparkplugReader& reader)
+{
+    const mqtt_session_data_t* ssn = get_pdu_data(p);
+    if (!ssn || !ssn->sparkplug)
+        return false;
+
+    reader.attach(ssn->payload, ssn->payload_len);
     return true;
 }
 
@@ -175,6 +303,14 @@ static int skip_remaining_length(const uint8_t* data, uint16_t dsize, uint32_t*
     return offset;
 }
 
+// Fixed-header flag nibble each packet type must carry, 0xFF = not fixed
+// (PUBLISH carries DUP/QoS/RETAIN, type 0 is reported as MQTT_RESERVED_TYPE)
+static const uint8_t mqtt_fixed_flags[16] =
+{
+    0xFF, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x02, 0x00,
+    0x02, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
 static void parse_fixed_header(Packet* p, mqtt_session_data_t* ssn)
 {
     if (p->dsize < 2)
@@ -186,7 +322,68 @@ static void parse_fixed_header(Packet* p, mqtt_session_data_t* ssn)
     ssn->dup_flag = (first_byte >> 3) & 0x01;
     ssn->qos = (first_byte >> 1) & 0x03;
     ssn->retain = first_byte & 0x01;
-    skip_remaining_length(p->data, p->dsize, &ssn->remaining_len);
+    int offset = skip_remaining_length(p->data, p->dsize, &ssn->remaining_len);
+
+    uint8_t required = mqtt_fixed_flags[ssn->msg_type];
+    if (required != 0xFF && (first_byte & 0x0F) != required)
+        ssn->conformance |= MQTT_CONF__BAD_FLAGS;
+
+    if (ssn->msg_type == 3) {
+        if (ssn->qos == 3)
+            ssn->conformance |= MQTT_CONF__BAD_QOS;
+        else if (ssn->qos == 0 && ssn->dup_flag)  // DUP must be 0 for QoS 0 (3.3.1.2)
+            ssn->conformance |= MQTT_CONF__BAD_FLAGS;
+    }
+
+    // Still continuing after the last byte read: longer than 4 bytes or cut short.
+    // A trailing 0x00 after a continuation byte is a non-minimal encoding.
+    uint8_t last = p->data[offset - 1];
+    if ((last & 0x80) || (offset > 2 && last == 0))
+        ssn->conformance |= MQTT_CONF__BAD_LENGTH_ENC;
+
+    if (static_cast<uint32_t>(offset) + ssn->remaining_len != p->dsize)
+        ssn->conformance |= MQTT_CONF__LENGTH_MISMATCH;
+}
+
+// Reads a 2-byte length prefixed field, flags it when it runs past the PDU
+static bool read_mqtt_string(Packet* p, int& offset, mqtt_session_data_t* ssn,
+    const uint8_t*& str, uint16_t& len)
+{
+    if (offset + 2 > p->dsize) {
+        ssn->conformance |= MQTT_CONF__STRING_OVERRUN;
+        return false;
+    }
+    len = (p->data[offset] << 8) | p->data[offset + 1];
+    offset += 2;
+
+    if (offset + len > p->dsize) {
+        ssn->conformance |= MQTT_CONF__STRING_OVERRUN;
+        return false;
+    }
+    if (len > 0)
+        str = p->data + offset;
+    offset += len;
+    return true;
+}
+
+// Names and filters must be UTF-8 without U+0000; binary fields (will
+// message, password) are not checked
+static void check_utf8(mqtt_session_data_t* ssn, const uint8_t* str, uint16_t len)
+{
+    if (len && !mqtt_valid_utf8(str, len))
+        ssn->conformance |= MQTT_CONF__BAD_UTF8;
+}
+
+// Reads an MQTT 5 property block. A malformed block is flagged; parsing can
+// go on after it as long as the block length itself was readable.
+static bool read_mqtt_props(Packet* p, int& offset, mqtt_session_data_t* ssn,
+    MqttPropIndex& props)
+{
+    if (props.parse(p->data, p->dsize, offset))
+        return true;
+
+    ssn->conformance |= MQTT_CONF__BAD_PROPERTY;
+    return props.pdu != nullptr;
 }
 
 static bool parse_connect_packet(Packet* p, mqtt_session_data_t* ssn)
@@ -196,15 +393,8 @@ static bool parse_connect_packet(Packet* p, mqtt_session_data_t* ssn)
     
     int offset = skip_remaining_length(p->data, p->dsize, nullptr);
     
-    if (offset + 2 > p->dsize)
-        return false;
-    ssn->proto_len = (p->data[offset] << 8) | p->data[offset + 1];
-    offset += 2;
-    
-    if (offset + ssn->proto_len > p->dsize)
+    if (!read_mqtt_string(p, offset, ssn, ssn->proto_name, ssn->proto_len))
         return false;
-    ssn->proto_name = p->data + offset;
-    offset += ssn->proto_len;
     
     if (offset + 4 > p->dsize)
         return false;
@@ -219,61 +409,59 @@ static bool parse_connect_packet(Packet* p, mqtt_session_data_t* ssn)
     ssn->conflag_uname = (ssn->connect_flags >> 7) & 0x01;
     ssn->keep_alive = (p->data[offset + 2] << 8) | p->data[offset + 3];
     offset += 4;
+
+    // "MQTT" goes with level 4 (3.1.1) or 5, the old "MQIsdp" with level 3 (3.1)
+    bool is_mqtt = ssn->proto_len == 4 && !memcmp(ssn->proto_name, "MQTT", 4);
+    bool is_mqisdp = ssn->proto_len == 6 && !memcmp(ssn->proto_name, "MQIsdp", 6);
+    if (!is_mqtt && !is_mqisdp)
+        ssn->conformance |= MQTT_CONF__BAD_PROTO_ID;
+    else if ((is_mqtt && ssn->protocol_version != 4 && ssn->protocol_version != 5) ||
+        (is_mqisdp && ssn->protocol_version != 3))
+        ssn->conformance |= MQTT_CONF__BAD_PROTO_LEVEL;
+
+    // Reserved bit, Will QoS 3, Will QoS/Retain without a Will, and (before
+    // MQTT 5) a password without a user name
+    if (ssn->conflag_reserved || ssn->conflag_will_qos == 3 ||
+        (!ssn->conflag_will_flag && (ssn->conflag_will_qos || ssn->conflag_will_retain)) ||
+        (ssn->conflag_passwd && !ssn->conflag_uname && ssn->protocol_version < 5))
+        ssn->conformance |= MQTT_CONF__BAD_CONNECT_FLAGS;
+
+    bool v5 = (ssn->protocol_version == 5);
+    if (v5 && !read_mqtt_props(p, offset, ssn, ssn->props))
+        return false;
     
-    if (offset + 2 > p->dsize)
+    if (!read_mqtt_string(p, offset, ssn, ssn->client_id, ssn->client_id_len))
         return false;
-    ssn->client_id_len = (p->data[offset] << 8) | p->data[offset + 1];
-    offset += 2;
-    if (ssn->client_id_len > 0 && offset + ssn->client_id_len <= p->dsize) {
-        ssn->client_id = p->data + offset;
-        offset += ssn->client_id_len;
-    }
+    check_utf8(ssn, ssn->client_id, ssn->client_id_len);
     
     if (ssn->conflag_will_flag) {
-        if (offset + 2 > p->dsize)
-            return true;
-        ssn->will_topic_len = (p->data[offset] << 8) | p->data[offset + 1];
-        offset += 2;
-        if (ssn->will_topic_len > 0 && offset + ssn->will_topic_len <= p->dsize) {
-            ssn->will_topic = p->data + offset;
-            offset += ssn->will_topic_len;
-        }
-        
-        if (offset + 2 > p->dsize)
-            return true;
-        ssn->will_msg_len = (p->data[offset] << 8) | p->data[offset + 1];
-        offset += 2;
-        if (ssn->will_msg_len > 0 && offset + ssn->will_msg_len <= p->dsize) {
-            ssn->will_msg = p->data + offset;
-            offset += ssn->will_msg_len;
+        if (v5) {
+            MqttPropIndex will_props = { };
+            if (!read_mqtt_props(p, offset, ssn, will_props))
+                return false;
         }
+        if (!read_mqtt_string(p, offset, ssn, ssn->will_topic, ssn->will_topic_len))
+            return false;
+        check_utf8(ssn, ssn->will_topic, ssn->will_topic_len);
+        if (!read_mqtt_string(p, offset, ssn, ssn->will_msg, ssn->will_msg_len))
+            return false;
     }
     
     if (ssn->conflag_uname) {
-        if (offset + 2 > p->dsize)
-            return true;
-        ssn->username_len = (p->data[offset] << 8) | p->data[offset + 1];
-        offset += 2;
-        if (ssn->username_len > 0 && offset + ssn->username_len <= p->dsize) {
-            ssn->username = p->data + offset;
-            offset += ssn->username_len;
-        }
+        if (!read_mqtt_string(p, offset, ssn, ssn->username, ssn->username_len))
+            return false;
+        check_utf8(ssn, ssn->username, ssn->username_len);
     }
     
     if (ssn->conflag_passwd) {
-        if (offset + 2 > p->dsize)
-            return true;
-        ssn->passwd_len = (p->data[offset] << 8) | p->data[offset + 1];
-        offset += 2;
-        if (ssn->passwd_len > 0 && offset + ssn->passwd_len <= p->dsize) {
-            ssn->password = p->data + offset;
-        }
+        if (!read_mqtt_string(p, offset, ssn, ssn->password, ssn->passwd_len))
+            return false;
     }
     
     return true;
 }
 
-static bool parse_connack_packet(Packet* p, mqtt_session_data_t* ssn)
+static bool parse_connack_packet(Packet* p, mqtt_session_data_t* ssn, uint8_t version)
 {
     if (p->dsize < 4)
         return false;
@@ -286,23 +474,21 @@ static bool parse_connack_packet(Packet* p, mqtt_session_data_t* ssn)
     ssn->conack_session_present = ssn->conack_flags & 0x01;
     ssn->conack_reserved = (ssn->conack_flags >> 1) & 0x7F;
     ssn->conack_return_code = p->data[offset + 1];
+    offset += 2;
+
+    if (version == 5 && offset < p->dsize)
+        read_mqtt_props(p, offset, ssn, ssn->props);
     
     return true;
 }
 
-static bool parse_publish_packet(Packet* p, mqtt_session_data_t* ssn)
+static bool parse_publish_packet(Packet* p, mqtt_session_data_t* ssn, uint8_t version)
 {
     int offset = skip_remaining_length(p->data, p->dsize, nullptr);
     
-    if (offset + 2 > p->dsize)
-        return false;
-    ssn->topic_len = (p->data[offset] << 8) | p->data[offset + 1];
-    offset += 2;
-    
-    if (offset + ssn->topic_len > p->dsize)
+    if (!read_mqtt_string(p, offset, ssn, ssn->topic, ssn->topic_len))
         return false;
-    ssn->topic = p->data + offset;
-    offset += ssn->topic_len;
+    check_utf8(ssn, ssn->topic, ssn->topic_len);
     
     if (ssn->qos > 0) {
         if (offset + 2 > p->dsize)
@@ -310,6 +496,9 @@ static bool parse_publish_packet(Packet* p, mqtt_session_data_t* ssn)
         ssn->msg_id = (p->data[offset] << 8) | p->data[offset + 1];
         offset += 2;
     }
+
+    if (version == 5 && !read_mqtt_props(p, offset, ssn, ssn->props))
+        return false;
     
     if (offset < p->dsize) {
         ssn->payload = p->data + offset;
@@ -319,7 +508,75 @@ static bool parse_publish_packet(Packet* p, mqtt_session_data_t* ssn)
     return true;
 }
 
-static bool parse_subscribe_packet(Packet* p, mqtt_session_data_t* ssn)
+// Reads just the packet identifier QoS 2 tracking needs and leaves the rest
+// of the PUBLISH to get_pdu_data()
+static void skim_publish_packet(Packet* p, mqtt_session_data_t* ssn)
+{
+    ssn->publish_deferred = 1;
+
+    if (ssn->qos != 2)
+        return;
+
+    int offset = skip_remaining_length(p->data, p->dsize, nullptr);
+    if (offset + 2 > p->dsize)
+        return;
+
+    offset += 2 + ((p->data[offset] << 8) | p->data[offset + 1]);
+    if (offset + 2 > p->dsize)
+        return;
+
+    ssn->msg_id = (p->data[offset] << 8) | p->data[offset + 1];
+}
+
+// Collects every topic filter of a SUBSCRIBE (with its options byte) or an
+// UNSUBSCRIBE into the filter arena. Nothing is copied and nothing capped.
+static void parse_topic_filters(Packet* p, int offset, mqtt_session_data_t* ssn,
+    bool has_options, uint8_t version)
+{
+    mqtt_filter_span_t* spans = mqtt_filter_arena;
+    ssn->filters = spans;
+
+    while (offset < p->dsize && ssn->filter_count < MQTT_FILTER_ARENA_SPANS) {
+        const uint8_t* filter = nullptr;
+        uint16_t len = 0;
+        int start = offset + 2;
+
+        if (!read_mqtt_string(p, offset, ssn, filter, len))
+            break;
+        check_utf8(ssn, filter, len);
+
+        uint8_t options = 0;
+        if (has_options) {
+            if (offset >= p->dsize) {
+                ssn->conformance |= MQTT_CONF__STRING_OVERRUN;
+                break;
+            }
+            options = p->data[offset++];
+
+            // QoS 3; reserved bits are 2-7 before MQTT 5, then 6-7 plus
+            // Retain Handling 3
+            if ((options & 0x03) == 3)
+                ssn->conformance |= MQTT_CONF__BAD_QOS;
+            if ((version == 5) ? ((options & 0xC0) || (options & 0x30) == 0x30) : (options & 0xFC))
+                ssn->conformance |= MQTT_CONF__BAD_FLAGS;
+        }
+
+        mqtt_filter_span_t& span = spans[ssn->filter_count++];
+        span.offset = start;
+        span.len = len;
+        span.options = options;
+
+        if (len) {
+            bool multi = memchr(filter, '#', len) != nullptr;
+            if (multi)
+                ssn->multilevel_count++;
+            if (multi || memchr(filter, '+', len))
+                ssn->wildcard_count++;
+        }
+    }
+}
+
+static bool parse_subscribe_packet(Packet* p, mqtt_session_data_t* ssn, uint8_t version)
 {
     int offset = skip_remaining_length(p->data, p->dsize, nullptr);
     
@@ -327,21 +584,16 @@ static bool parse_subscribe_packet(Packet* p, mqtt_session_data_t* ssn)
         return false;
     ssn->msg_id = (p->data[offset] << 8) | p->data[offset + 1];
     offset += 2;
-    
-    ssn->sub_qos_count = 0;
-    while (offset + 2 < p->dsize && ssn->sub_qos_count < 8) {
-        uint16_t topic_len = (p->data[offset] << 8) | p->data[offset + 1];
-        offset += 2 + topic_len;
-        if (offset < p->dsize) {
-            ssn->sub_qos[ssn->sub_qos_count++] = p->data[offset] & 0x03;
-            offset++;
-        }
-    }
+
+    if (version == 5 && !read_mqtt_props(p, offset, ssn, ssn->props))
+        return false;
+
+    parse_topic_filters(p, offset, ssn, true, version);
     
     return true;
 }
 
-static bool parse_suback_packet(Packet* p, mqtt_session_data_t* ssn)
+static bool parse_suback_packet(Packet* p, mqtt_session_data_t* ssn, uint8_t version)
 {
     int offset = skip_remaining_length(p->data, p->dsize, nullptr);
     
@@ -349,8 +601,12 @@ static bool parse_suback_packet(Packet* p, mqtt_session_data_t* ssn)
         return false;
     ssn->msg_id = (p->data[offset] << 8) | p->data[offset + 1];
     offset += 2;
+
+    if (version == 5 && !read_mqtt_props(p, offset, ssn, ssn->props))
+        return false;
     
     ssn->suback_qos_count = 0;
+    ssn->suback_code_count = p->dsize > offset ? p->dsize - offset : 0;
     while (offset < p->dsize && ssn->suback_qos_count < 8) {
         ssn->suback_qos[ssn->suback_qos_count++] = p->data[offset];
         offset++;
@@ -359,28 +615,67 @@ static bool parse_suback_packet(Packet* p, mqtt_session_data_t* ssn)
     return true;
 }
 
-static bool parse_unsubscribe_packet(Packet* p, mqtt_session_data_t* ssn)
+static bool parse_unsubscribe_packet(Packet* p, mqtt_session_data_t* ssn, uint8_t version)
 {
     int offset = skip_remaining_length(p->data, p->dsize, nullptr);
     
     if (offset + 2 > p->dsize)
         return false;
     ssn->msg_id = (p->data[offset] << 8) | p->data[offset + 1];
+    offset += 2;
+
+    if (version == 5 && !read_mqtt_props(p, offset, ssn, ssn->props))
+        return false;
+
+    parse_topic_filters(p, offset, ssn, false, version);
     
     return true;
 }
 
-static bool parse_ack_packet(Packet* p, mqtt_session_data_t* ssn)
+static bool parse_ack_packet(Packet* p, mqtt_session_data_t* ssn, uint8_t version)
 {
     int offset = skip_remaining_length(p->data, p->dsize, nullptr);
     
     if (offset + 2 > p->dsize)
         return false;
     ssn->msg_id = (p->data[offset] << 8) | p->data[offset + 1];
+    offset += 2;
+
+    if (version != 5)
+        return true;
+
+    // MQTT 5 UNSUBACK is laid out like SUBACK: properties, then one reason
+    // code per filter. The PUBLISH acks put a single reason code first, and
+    // both it and the properties may be left out.
+    if (ssn->msg_type == 11) {
+        if (!read_mqtt_props(p, offset, ssn, ssn->props))
+            return false;
+        if (offset < p->dsize)
+            ssn->reason_code = p->data[offset];
+        return true;
+    }
+
+    if (offset < p->dsize)
+        ssn->reason_code = p->data[offset++];
+    if (offset < p->dsize)
+        read_mqtt_props(p, offset, ssn, ssn->props);
     
     return true;
 }
 
+// MQTT 5 DISCONNECT and AUTH: optional reason code, then optional properties
+static bool parse_reason_packet(Packet* p, mqtt_session_data_t* ssn)
+{
+    int offset = skip_remaining_length(p->data, p->dsize, nullptr);
+
+    if (offset < p->dsize)
+        ssn->reason_code = p->data[offset++];
+    if (offset < p->dsize)
+        read_mqtt_props(p, offset, ssn, ssn->props);
+
+    return true;
+}
+
 //-------------------------------------------------------------------------
 // flow stuff
 //-------------------------------------------------------------------------
@@ -390,12 +685,29 @@ unsigned MqttFlowData::inspector_id = 0;
 void MqttFlowData::init()
 {
     inspector_id = FlowData::create_flow_data_id();
+    MqttProtoState::init_table();
 }
 
-MqttFlowData::MqttFlowData() : FlowData(inspector_id) // naming inspired by modbus
+MqttFlowData::MqttFlowData(const MqttConfig& conf) : FlowData(inspector_id), // naming inspired by modbus
+    qos2(conf.qos2_max_inflight, conf.qos2_stall_timeout * 1000000000ULL),
+    aliases { { conf.topic_alias_max, conf.topic_alias_max_len },
+              { conf.topic_alias_max, conf.topic_alias_max_len } }
 {
+    keepalive_timer.flow = this;
     reset();
     memset(&timing, 0, sizeof(timing));
+    memset(&rates, 0, sizeof(rates));
+    memset(&trust, 0, sizeof(trust));
+    proto_state.init(false);
+    protocol_version = 0;
+    demand = MQTT_DEMAND__ALL;
+    flow = nullptr;
+    acl_policy = -1;
+    acl_generation = 0;
+    registry_key = 0;
+    pending_key = 0;
+    connect_pending = false;
+    acl_identity = false;
     mqtt_stats.concurrent_sessions++;
     if(mqtt_stats.max_concurrent_sessions < mqtt_stats.concurrent_sessions)
         mqtt_stats.max_concurrent_sessions = mqtt_stats.concurrent_sessions;
@@ -403,47 +715,93 @@ MqttFlowData::MqttFlowData() : FlowData(inspector_id) // naming inspired by modb
 
 MqttFlowData::~MqttFlowData()
 {
+    if (mqtt_keepalive_wheel)
+        mqtt_keepalive_wheel->cancel(&keepalive_timer);
+    if (registry)
+        registry->release(registry_key, reinterpret_cast<uintptr_t>(this));
     assert(mqtt_stats.concurrent_sessions > 0);
     mqtt_stats.concurrent_sessions--;
 }
 
-void MqttFlowData::update_timing(const struct timeval& pkt_time)
+void MqttFlowData::update_timing(uint64_t now_ns, uint32_t bytes, bool is_publish)
 {
     if (timing.pkt_count == 0) {
-        timing.first_pkt_time = pkt_time;
+        timing.first_pkt_ns = now_ns;
+        timing.prev_pkt_ns = now_ns;
+        rates.rate_ns = now_ns;
     }
-    timing.prev_pkt_time = pkt_time;
+
+    // Packet time can step back a little across reassembled PDUs, treat that as no gap
+    timing.last_gap_ns = now_ns > timing.prev_pkt_ns ? now_ns - timing.prev_pkt_ns : 0;
+    timing.prev_pkt_ns = now_ns;
     timing.pkt_count++;
+
+    if (timing.pkt_count >= 2) {
+        // Exponentially weighted mean and variance, updated Welford-style so
+        // the variance never needs the sum of squares
+        double x = static_cast<double>(timing.last_gap_ns);
+        if (timing.pkt_count == 2) {
+            rates.iat_mean_ns = x;
+            rates.iat_var_ns2 = 0.0;
+        } else {
+            double diff = x - rates.iat_mean_ns;
+            double incr = MQTT_IAT_EWMA_ALPHA * diff;
+            rates.iat_mean_ns += incr;
+            rates.iat_var_ns2 = (1.0 - MQTT_IAT_EWMA_ALPHA) * (rates.iat_var_ns2 + diff * incr);
+        }
+    }
+
+    // Decay the rates to now, then add this PDU's contribution spread over tau
+    if (now_ns > rates.rate_ns) {
+        double decay = std::exp(-static_cast<double>(now_ns - rates.rate_ns) / MQTT_RATE_TAU_NS);
+        rates.publish_rate *= decay;
+        rates.byte_rate *= decay;
+        rates.rate_ns = now_ns;
+    }
+    rates.byte_rate += bytes * (1e9 / MQTT_RATE_TAU_NS);
+    if (is_publish)
+        rates.publish_rate += 1e9 / MQTT_RATE_TAU_NS;
 }
 
 int64_t MqttFlowData::get_time_delta_us() const
 {
     if (timing.pkt_count < 2)
         return 0;
-    return (timing.prev_pkt_time.tv_sec - timing.first_pkt_time.tv_sec) * 1000000LL +
-           (timing.prev_pkt_time.tv_usec - timing.first_pkt_time.tv_usec);
+    return static_cast<int64_t>(timing.last_gap_ns / 1000);
 }
 
 int64_t MqttFlowData::get_time_relative_us() const
 {
     if (timing.pkt_count == 0)
         return 0;
-    return (timing.prev_pkt_time.tv_sec - timing.first_pkt_time.tv_sec) * 1000000LL +
-           (timing.prev_pkt_time.tv_usec - timing.first_pkt_time.tv_usec);
+    return static_cast<int64_t>((timing.prev_pkt_ns - timing.first_pkt_ns) / 1000);
+}
+
+double MqttFlowData::get_iat_stddev_ns() const
+{
+    return std::sqrt(rates.iat_var_ns2);
+}
+
+double MqttFlowData::get_burstiness() const
+{
+    // Goh-Barabasi burstiness: -1 perfectly periodic, 0 Poisson, towards 1 bursty
+    double sigma = get_iat_stddev_ns();
+    double mu = rates.iat_mean_ns;
+    if (sigma + mu <= 0.0)
+        return 0.0;
+    return (sigma - mu) / (sigma + mu);
 }
 
-void MqttFlowData::record_auth_failure(const struct timeval& pkt_time)
+void MqttFlowData::record_auth_failure(uint64_t now_ns)
 {
     timing.failed_auth_count++;
     
     if (timing.failed_auth_window_count == 0) {
-        timing.failed_auth_window_start = pkt_time;
+        timing.failed_auth_window_start_ns = now_ns;
         timing.failed_auth_window_count = 1;
     } else {
-        int64_t window_elapsed = (pkt_time.tv_sec - timing.failed_auth_window_start.tv_sec) * 1000000LL +
-                                 (pkt_time.tv_usec - timing.failed_auth_window_start.tv_usec);
-        if (window_elapsed > 1000000) {
-            timing.failed_auth_window_start = pkt_time;
+        if (now_ns - timing.failed_auth_window_start_ns > 1000000000ULL) {
+            timing.failed_auth_window_start_ns = now_ns;
             timing.failed_auth_window_count = 1;
         } else {
             timing.failed_auth_window_count++;
@@ -451,18 +809,16 @@ void MqttFlowData::record_auth_failure(const struct timeval& pkt_time)
     }
 }
 
-float MqttFlowData::get_failed_auth_per_second(const struct timeval& pkt_time) const
+float MqttFlowData::get_failed_auth_per_second(uint64_t now_ns) const
 {
     if (timing.failed_auth_window_count == 0)
         return 0.0f;
     
-    int64_t window_elapsed = (pkt_time.tv_sec - timing.failed_auth_window_start.tv_sec) * 1000000LL +
-                             (pkt_time.tv_usec - timing.failed_auth_window_start.tv_usec);
-    
-    if (window_elapsed <= 0)
+    if (now_ns <= timing.failed_auth_window_start_ns)
         return static_cast<float>(timing.failed_auth_window_count);
     
-    return static_cast<float>(timing.failed_auth_window_count) * 1000000.0f / static_cast<float>(window_elapsed);
+    uint64_t window_elapsed_ns = now_ns - timing.failed_auth_window_start_ns;
+    return static_cast<float>(timing.failed_auth_window_count) * 1e9f / static_cast<float>(window_elapsed_ns);
 }
 
 //-------------------------------------------------------------------------
@@ -472,6 +828,12 @@ float MqttFlowData::get_failed_auth_per_second(const struct timeval& pkt_time) c
 class Mqtt : public Inspector
 {
 public:
+    Mqtt(const MqttConfig& c) : conf(c) { }
+
+    bool configure(SnortConfig*) override;
+    void show(const SnortConfig*) const override;
+    void tinit() override;
+    void tterm() override;
     void eval(Packet*) override;
     
     bool get_buf(InspectionBuffer::Type ibt, Packet* p, InspectionBuffer& b) override
@@ -483,40 +845,919 @@ public:
             case MQTT_TOPIC_BUFID: return get_buf_mqtt_topic(p, b);
             case MQTT_PAYLOAD_BUFID: return get_buf_mqtt_payload(p, b);
             case MQTT_CLIENT_ID_BUFID: return get_buf_mqtt_client_id(p, b);
+            case MQTT_CONTENT_TYPE_BUFID: return get_buf_mqtt_content_type(p, b);
+            case MQTT_PROPERTIES_BUFID: return get_buf_mqtt_properties(p, b);
+            case MQTT_SUB_TOPIC_BUFID: return get_buf_mqtt_sub_topic(p, 0, b);
+            case MQTT_USERNAME_BUFID: return get_buf_mqtt_username(p, b);
+            case MQTT_WILL_TOPIC_BUFID: return get_buf_mqtt_will_topic(p, b);
+            case MQTT_WILL_MESSAGE_BUFID: return get_buf_mqtt_will_message(p, b);
+            case MQTT_PAYLOAD_DECOMPRESSED_BUFID: return get_buf_mqtt_payload_decompressed(p, b);
         }
         return false;
     }
 
     StreamSplitter* get_splitter(bool c2s) override
     { return new MqttSplitter(c2s); }
+
+private:
+    MqttConfig conf;
+    std::unique_ptr<MqttSourceTable> sources;   // Shared by the packet threads
+    std::shared_ptr<MqttClientRegistry> registry;   // Shared with the flows holding ids
+    std::unique_ptr<MqttRateLimiter> connect_limiter;
+    std::unique_ptr<MqttAclBinding> acl;
+    bool topic_baselines = false;   // Topic table with alerting baselines
+    bool trust_bypass = false;      // trust = bypass and nothing needs every PUBLISH
+
+    void track_qos2(Packet*, MqttFlowData*, uint64_t now_ns);
+    void track_keepalive(Packet*, MqttFlowData*, uint64_t now_ns);
+    mqtt_sm_violation_t check_state(Packet*, MqttFlowData*);
+    void resolve_topic_alias(Packet*, MqttFlowData*);
+    bool check_acl(Packet*, MqttFlowData*);
+    void decode_sparkplug(Packet*, MqttFlowData*);
+    bool count_topic(MqttFlowData*, uint64_t now_ns);
+    void track_heavy_hitters(Packet*, MqttFlowData*, uint64_t now_ns);
+    void count_credentials(Packet*, MqttFlowData*, uint64_t now_ns);
+    void expect_client_id(MqttFlowData*);
+    void register_client_id(Packet*, MqttFlowData*, uint64_t now_ns);
+    bool limit_connect_rate(Packet*, uint64_t now_ns);
+    bool trusted_fast_path(Packet*, MqttFlowData*, uint64_t now_ns);
+    void update_trust(Packet*, MqttFlowData*, bool clean, uint64_t now_ns);
+    bool check_baseline(float& zscore, MqttWelford&, double x, double floor,
+        uint32_t sid, PegCount& anomalies);
 };
 
-void Mqtt::eval(Packet* p)
+bool Mqtt::configure(SnortConfig*)
 {
-    Profile profile(mqtt_prof);   // cppcheck-suppress unreadVariable
+    if (conf.source_table_size)
+    {
+        const uint32_t limits[MQTT_DISTINCT__MAX] =
+        {
+            conf.distinct_username_limit,
+            conf.distinct_password_limit,
+            conf.distinct_client_id_limit
+        };
+        sources.reset(new MqttSourceTable(conf.source_table_size, conf.source_window, limits));
+    }
 
-    // Preconditions - what we registered for
-    assert(p->has_tcp_data()); // Only called when payload exists
+    if (conf.connect_rate > 0.0)
+        connect_limiter.reset(new MqttRateLimiter(conf.connect_rate_buckets, conf.connect_rate,
+            conf.connect_burst));
 
-    MqttFlowData* mfd =
-        (MqttFlowData*)p->flow->get_flow_data(MqttFlowData::inspector_id);
+    if (conf.client_registry_size)
+        registry = std::make_shared<MqttClientRegistry>(conf.client_registry_size,
+            conf.client_id_flap_window);
 
-    if ( !p->is_full_pdu() )
-    {
-        if ( mfd )
-            mfd->reset();
+    topic_baselines = conf.topic_table_memcap && conf.baseline_sigma > 0.0;
 
-        // If a packet is rebuilt, but not a full PDU, then it's garbage that
-        // got flushed at the end of a stream.
-        if ( p->packet_flags & (PKT_REBUILT_STREAM|PKT_PDU_HEAD) )
-            DetectionEngine::queue_event(GID_MQTT, MQTT_BAD_LENGTH);
+    // Ending inspection would end the ACL and baseline checks with it
+    trust_bypass = conf.trust == MQTT_TRUST__BYPASS && conf.acl_file.empty() && !topic_baselines;
 
-        return;
-    }
+    if (conf.trust == MQTT_TRUST__BYPASS && !trust_bypass)
+        WarningMessage("mqtt: trust = bypass would end the topic ACL and baseline checks, "
+            "trusted flows are sampled instead\n");
+
+    if (conf.acl_file.empty())
+        return true;
+
+    std::string error;
+    std::shared_ptr<const MqttAcl> loaded = MqttAcl::load(conf.acl_file, error);
+    if (!loaded)
+    {
+        ParseError("mqtt: %s", error.c_str());
+        return false;
+    }
+
+    acl.reset(new MqttAclBinding(loaded, conf.acl_file));
+    return true;
+}
+
+static const char* const rate_actions[] = { "alert", "drop", "block" };
+static const char* const trust_modes[] = { "off", "bypass", "sample" };
+
+void Mqtt::show(const SnortConfig*) const
+{
+    ConfigLogger::log_value("qos2_max_inflight", conf.qos2_max_inflight);
+    ConfigLogger::log_value("qos2_stall_timeout", conf.qos2_stall_timeout);
+    ConfigLogger::log_value("keepalive_factor", conf.keepalive_factor);
+    ConfigLogger::log_value("keepalive_trickle_count", conf.keepalive_trickle_count);
+    ConfigLogger::log_value("topic_alias_max", conf.topic_alias_max);
+    ConfigLogger::log_value("topic_alias_max_len", conf.topic_alias_max_len);
+    ConfigLogger::log_value("acl_file", conf.acl_file.c_str());
+    ConfigLogger::log_flag("acl_drop", conf.acl_drop);
+    ConfigLogger::log_flag("decompress", conf.decompress);
+    ConfigLogger::log_value("decompress_max", conf.decompress_max);
+    ConfigLogger::log_value("decompress_ratio", conf.decompress_ratio);
+    ConfigLogger::log_flag("sparkplug", conf.sparkplug);
+    ConfigLogger::log_value("topic_table_memcap", conf.topic_table_memcap);
+    ConfigLogger::log_value("baseline_sigma", conf.baseline_sigma);
+    ConfigLogger::log_value("baseline_min_samples", conf.baseline_min_samples);
+    ConfigLogger::log_flag("payload_profile", conf.payload_profile);
+    ConfigLogger::log_value("payload_profile_len", conf.payload_profile_len);
+    ConfigLogger::log_value("heavy_hitters", conf.heavy_hitters);
+    ConfigLogger::log_value("heavy_hitter_interval", conf.heavy_hitter_interval);
+    ConfigLogger::log_value("source_table_size", conf.source_table_size);
+    ConfigLogger::log_value("source_window", conf.source_window);
+    ConfigLogger::log_value("distinct_username_limit", conf.distinct_username_limit);
+    ConfigLogger::log_value("distinct_password_limit", conf.distinct_password_limit);
+    ConfigLogger::log_value("distinct_client_id_limit", conf.distinct_client_id_limit);
+    ConfigLogger::log_value("client_registry_size", conf.client_registry_size);
+    ConfigLogger::log_value("client_id_flap_window", conf.client_id_flap_window);
+    ConfigLogger::log_value("client_id_flap_limit", conf.client_id_flap_limit);
+    ConfigLogger::log_value("connect_rate", conf.connect_rate);
+    ConfigLogger::log_value("connect_burst", conf.connect_burst);
+    ConfigLogger::log_value("connect_rate_buckets", conf.connect_rate_buckets);
+    ConfigLogger::log_value("connect_rate_action", rate_actions[conf.connect_rate_action]);
+    ConfigLogger::log_value("trust", trust_modes[conf.trust]);
+    ConfigLogger::log_value("trust_after_packets", conf.trust_after_packets);
+    ConfigLogger::log_value("trust_after_seconds", conf.trust_after_seconds);
+    ConfigLogger::log_value("trust_sample", conf.trust_sample);
+    ConfigLogger::log_flag("lazy_parse", conf.lazy_parse);
+}
+
+void Mqtt::tinit()
+{
+    delete mqtt_inflater;
+    mqtt_inflater = nullptr;
+
+    if (conf.decompress)
+        mqtt_inflater = new MqttInflater(conf.decompress_max, conf.decompress_ratio);
+
+    delete mqtt_topic_table;
+    mqtt_topic_table = nullptr;
+
+    if (conf.topic_table_memcap)
+        mqtt_topic_table = new MqttTopicTable(conf.topic_table_memcap);
+
+    delete mqtt_heavy_hitters;
+    mqtt_heavy_hitters = nullptr;
+
+    if (conf.heavy_hitters)
+        mqtt_heavy_hitters = new MqttHeavyHitters(conf.heavy_hitters);
+
+    // Rules and subscribers are all in place by now. The feature event and
+    // the detectors below read the PUBLISH fields themselves.
+    if (!conf.lazy_parse)
+        mqtt_thread_demand = MQTT_DEMAND__ALL;
+    else
+    {
+        mqtt_thread_demand = mqtt_get_demand();
+
+        if ((mqtt_thread_demand & MQTT_DEMAND__FEATURES) || !conf.acl_file.empty() ||
+            conf.topic_table_memcap || conf.heavy_hitters)
+            mqtt_thread_demand |= MQTT_DEMAND__PUBLISH;
+    }
+
+    mqtt_thread_owner = this;
+}
+
+void Mqtt::tterm()
+{
+    if (acl)
+        acl->thread_release();
+
+    if (mqtt_thread_owner != this)
+        return;
+
+    delete mqtt_inflater;
+    mqtt_inflater = nullptr;
+    delete mqtt_topic_table;
+    mqtt_topic_table = nullptr;
+    delete mqtt_heavy_hitters;
+    mqtt_heavy_hitters = nullptr;
+    mqtt_thread_owner = nullptr;
+}
+
+// Follows QoS 2 packet identifiers through PUBLISH→PUBREC→PUBREL→PUBCOMP
+void Mqtt::track_qos2(Packet* p, MqttFlowData* mfd, uint64_t now_ns)
+{
+    const mqtt_session_data_t& ssn = mfd->ssn_data;
+    bool is_qos2_msg = (ssn.msg_type == 3 && ssn.qos == 2) ||
+        (ssn.msg_type >= 5 && ssn.msg_type <= 7);
+
+    if (is_qos2_msg)
+    {
+        switch (mfd->qos2.update(ssn.msg_type, ssn.msg_id, p->is_from_client(),
+            ssn.dup_flag, now_ns))
+        {
+        case MQTT_QOS2_RESULT__OK:
+            if (ssn.msg_type == 3 && !ssn.dup_flag)
+                mqtt_stats.qos2_handshakes++;
+            else if (ssn.msg_type == 7)
+                mqtt_stats.qos2_completed++;
+            break;
+
+        case MQTT_QOS2_RESULT__DUPLICATE:
+            mqtt_stats.qos2_dup_ids++;
+            DetectionEngine::queue_event(GID_MQTT, MQTT_QOS2_DUP_ID);
+            break;
+
+        case MQTT_QOS2_RESULT__UNKNOWN:
+            mqtt_stats.qos2_unknown_ids++;
+            break;
+
+        case MQTT_QOS2_RESULT__FULL:
+            mqtt_stats.qos2_table_full++;
+            DetectionEngine::queue_event(GID_MQTT, MQTT_QOS2_TABLE_FULL);
+            break;
+        }
+    }
+
+    // Any packet on the flow moves the clock, so stalls surface even when
+    // the attacker keeps the connection alive with PINGREQ only
+    if (uint32_t newly = mfd->qos2.check_stalled(now_ns))
+    {
+        mqtt_stats.qos2_stalled += newly;
+        DetectionEngine::queue_event(GID_MQTT, MQTT_QOS2_STALLED);
+    }
+}
+
+// One SID and one peg per conformance bit
+static const struct
+{
+    uint32_t bit;
+    unsigned sid;
+    PegCount MqttStats::* peg;
+} conformance_checks[] =
+{
+    { MQTT_CONF__BAD_FLAGS, MQTT_BAD_FLAGS, &MqttStats::bad_flags },
+    { MQTT_CONF__BAD_QOS, MQTT_BAD_QOS, &MqttStats::bad_qos },
+    { MQTT_CONF__BAD_LENGTH_ENC, MQTT_BAD_LENGTH_ENC, &MqttStats::bad_length_enc },
+    { MQTT_CONF__LENGTH_MISMATCH, MQTT_LENGTH_MISMATCH, &MqttStats::length_mismatch },
+    { MQTT_CONF__BAD_PROTO_ID, MQTT_BAD_PROTO_ID, &MqttStats::bad_proto_id },
+    { MQTT_CONF__BAD_PROTO_LEVEL, MQTT_BAD_PROTO_LEVEL, &MqttStats::bad_proto_level },
+    { MQTT_CONF__BAD_CONNECT_FLAGS, MQTT_BAD_CONNECT_FLAGS, &MqttStats::bad_connect_flags },
+    { MQTT_CONF__STRING_OVERRUN, MQTT_STRING_OVERRUN, &MqttStats::string_overrun },
+    { MQTT_CONF__BAD_PROPERTY, MQTT_BAD_PROPERTY, &MqttStats::bad_property },
+    { MQTT_CONF__BAD_UTF8, MQTT_BAD_UTF8, &MqttStats::bad_utf8 },
+};
+
+static void raise_conformance_events(uint32_t conformance)
+{
+    if (!conformance)
+        return;
+
+    for (const auto& check : conformance_checks)
+    {
+        if (conformance & check.bit)
+        {
+            mqtt_stats.*check.peg += 1;
+            DetectionEngine::queue_event(GID_MQTT, check.sid);
+        }
+    }
+}
+
+static const unsigned state_violation_sids[MQTT_SM__MAX] =
+{
+    0,
+    MQTT_CONNECT_NOT_FIRST,
+    MQTT_DUPLICATE_CONNECT,
+    MQTT_PKT_AFTER_REFUSED,
+    MQTT_WRONG_DIRECTION,
+    MQTT_PKT_AFTER_DISCONNECT,
+};
+
+// Validates the PDU against the connection state machine, before any ML work
+mqtt_sm_violation_t Mqtt::check_state(Packet* p, MqttFlowData* mfd)
+{
+    const mqtt_session_data_t& ssn = mfd->ssn_data;
+
+    mqtt_sm_violation_t violation = mfd->proto_state.update(ssn.msg_type,
+        ssn.msg_type == 2 && ssn.conack_return_code != 0, p->is_from_client());
+
+    if (violation != MQTT_SM__OK)
+    {
+        mqtt_stats.state_violations++;
+        DetectionEngine::queue_event(GID_MQTT, state_violation_sids[violation]);
+        return violation;
+    }
+
+    if (ssn.msg_type == 8)  // SUBSCRIBE
+        mfd->proto_state.on_subscribe(ssn.msg_id, ssn.filter_count);
+
+    else if (ssn.msg_type == 9 &&  // SUBACK
+        !mfd->proto_state.on_suback(ssn.msg_id, ssn.suback_code_count))
+    {
+        mqtt_stats.suback_mismatches++;
+        DetectionEngine::queue_event(GID_MQTT, MQTT_SUBACK_MISMATCH);
+    }
+
+    return violation;
+}
+
+// A PUBLISH with a topic and an alias (re)assigns the alias, one with an
+// empty topic uses it. The resolved topic replaces the empty one so the
+// mqtt_topic buffer and the topic features see the real topic.
+void Mqtt::resolve_topic_alias(Packet* p, MqttFlowData* mfd)
+{
+    mqtt_session_data_t& ssn = mfd->ssn_data;
+    MqttTopicAliases& aliases = mfd->aliases[p->is_from_client() ? 0 : 1];
+    uint16_t alias = ssn.props.get_int(MQTT_PROP__TOPIC_ALIAS);
+
+    if (!ssn.props.has(MQTT_PROP__TOPIC_ALIAS))
+    {
+        // Without an alias the topic is mandatory
+        if (ssn.topic_len == 0)
+        {
+            mqtt_stats.topic_alias_errors++;
+            DetectionEngine::queue_event(GID_MQTT, MQTT_BAD_TOPIC_ALIAS);
+        }
+        return;
+    }
+
+    mqtt_alias_result_t r;
+
+    if (ssn.topic_len)
+    {
+        r = aliases.assign(alias, ssn.topic, ssn.topic_len);
+        if (r == MQTT_ALIAS_RESULT__OK)
+            mqtt_stats.topic_alias_assigned++;
+    }
+    else
+    {
+        r = aliases.resolve(alias, ssn.topic, ssn.topic_len);
+        if (r == MQTT_ALIAS_RESULT__OK)
+        {
+            ssn.topic_from_alias = 1;
+            mqtt_stats.topic_alias_resolved++;
+        }
+    }
+
+    if (r == MQTT_ALIAS_RESULT__OUT_OF_RANGE || r == MQTT_ALIAS_RESULT__UNKNOWN)
+    {
+        mqtt_stats.topic_alias_errors++;
+        DetectionEngine::queue_event(GID_MQTT, MQTT_BAD_TOPIC_ALIAS);
+    }
+    else if (r == MQTT_ALIAS_RESULT__NOT_CACHED)
+        mqtt_stats.topic_alias_uncached++;
+}
+
+// Client PUBLISH topics and SUBSCRIBE filters must be allowed by the
+// policy of the CONNECT identity. The policy is looked up again whenever
+// a new ACL was loaded; flows picked up midstream have no identity and
+// are not restricted.
+bool Mqtt::check_acl(Packet* p, MqttFlowData* mfd)
+{
+    const mqtt_session_data_t& ssn = mfd->ssn_data;
+    if (!p->is_from_client() || (ssn.msg_type != 3 && ssn.msg_type != 8))
+        return false;
+
+    if (!acl)
+        return false;
+
+    unsigned generation;
+    const MqttAcl* current = acl->get(generation);
+    if (!current)
+        return false;
+
+    if (mfd->acl_generation != generation)
+    {
+        mfd->acl_generation = generation;
+        mfd->acl_policy = mfd->acl_identity ?
+            current->find_policy(mfd->acl_client_id, mfd->acl_username) : -1;
+    }
+
+    if (mfd->acl_policy < 0)
+        return false;
+
+    bool denied = false;
+
+    if (ssn.msg_type == 3)
+    {
+        // An alias that could not be resolved leaves no topic to check
+        if (ssn.topic_len)
+        {
+            bool allowed = current->allow_publish(mfd->acl_policy, ssn.topic, ssn.topic_len);
+            acl->count(mfd->acl_policy, allowed);
+
+            if (!allowed)
+            {
+                mqtt_stats.acl_publish_denied++;
+                DetectionEngine::queue_event(GID_MQTT, MQTT_ACL_PUBLISH_DENIED);
+                denied = true;
+            }
+        }
+    }
+    else
+    {
+        for (unsigned i = 0; i < ssn.filter_count; i++)
+        {
+            const mqtt_filter_span_t& f = ssn.filters[i];
+            bool allowed = current->allow_subscribe(mfd->acl_policy, p->data + f.offset, f.len);
+            acl->count(mfd->acl_policy, allowed);
+
+            if (!allowed)
+            {
+                mqtt_stats.acl_subscribe_denied++;
+                denied = true;
+            }
+        }
+        if (denied)
+            DetectionEngine::queue_event(GID_MQTT, MQTT_ACL_SUBSCRIBE_DENIED);
+    }
+
+    if (denied && conf.acl_drop)
+    {
+        mqtt_stats.acl_drops++;
+        p->active->drop_packet(p);
+    }
+    return denied;
+}
+
+// Interns the PUBLISH topic, resolved alias included, counts the message
+// against it and compares it with the topic's size and interval baselines.
+// Every sample is folded into the baselines, so a topic that really
+// changes its behavior stops alerting once the baselines catch up.
+bool Mqtt::count_topic(MqttFlowData* mfd, uint64_t now_ns)
+{
+    mqtt_session_data_t& ssn = mfd->ssn_data;
+
+    if (!mqtt_topic_table || !ssn.topic_len)
+        return false;
+
+    bool fresh;
+    ssn.topic_id = mqtt_topic_table->intern(ssn.topic, ssn.topic_len, fresh);
+
+    if (!ssn.topic_id)
+        return false;
+
+    if (ssn.topic_len > MQTT_TOPIC_MAX_LEN)
+        mqtt_stats.long_topics++;
+
+    MqttTopicStats& ts = mqtt_topic_table->get_stats(ssn.topic_id);
+    bool anomaly = false;
+
+    if (fresh)
+        ts.first_seen_ns = now_ns;
+    else
+        anomaly = check_baseline(ssn.interval_zscore, ts.interval,
+            now_ns > ts.last_seen_ns ? (now_ns - ts.last_seen_ns) / 1000.0 : 0.0,
+            MQTT_BASELINE_INTERVAL_FLOOR_US,
+            MQTT_TOPIC_INTERVAL_ANOMALY, mqtt_stats.interval_anomalies);
+
+    if (check_baseline(ssn.size_zscore, ts.size, ssn.payload_len, MQTT_BASELINE_SIZE_FLOOR,
+        MQTT_TOPIC_SIZE_ANOMALY, mqtt_stats.size_anomalies))
+        anomaly = true;
+
+    ts.messages++;
+    ts.bytes += ssn.payload_len;
+    ts.last_seen_ns = now_ns;
+    return anomaly;
+}
+
+bool Mqtt::check_baseline(float& zscore, MqttWelford& w, double x, double floor,
+    uint32_t sid, PegCount& anomalies)
+{
+    bool anomaly = false;
+
+    if (w.n >= conf.baseline_min_samples)
+    {
+        double z = w.zscore(x, floor);
+        zscore = static_cast<float>(z);
+
+        if (conf.baseline_sigma > 0.0 && z > conf.baseline_sigma)
+        {
+            anomalies++;
+            DetectionEngine::queue_event(GID_MQTT, sid);
+            anomaly = true;
+        }
+    }
+    w.add(x);
+    return anomaly;
+}
+
+// Trusted flows skip the rest of inspection for the plain PUBLISH, PUBACK
+// and keep-alive PDUs that make up nearly all of their traffic. The PDU is
+// still parsed and the state machine still checked, and anything wrong goes
+// back through the full path, which raises the events and re-arms the flow.
+// The topic ACL and the topic baselines are never sampled: a PUBLISH they
+// flag keeps its detection and takes the flow's trust away. QoS 2 and
+// everything else always take the full path so their trackers stay right.
+bool Mqtt::trusted_fast_path(Packet* p, MqttFlowData* mfd, uint64_t now_ns)
+{
+    mqtt_trust_t& t = mfd->trust;
+    mqtt_session_data_t& ssn = mfd->ssn_data;
+
+    if (!t.trusted)
+        return false;
+
+    switch (ssn.msg_type)
+    {
+    case 3:  // PUBLISH
+        if (ssn.qos == 2)
+            return false;
+        break;
+
+    case 4:  // PUBACK
+    case 12: // PINGREQ
+    case 13: // PINGRESP
+        break;
+
+    default:
+        return false;
+    }
+
+    if (++t.since_sample >= conf.trust_sample)
+    {
+        t.since_sample = 0;
+        return false;
+    }
+
+    // The parse is what finds bad strings and properties; the full path
+    // parses the PDU again and raises them
+    bool parsed = true;
+
+    if (ssn.msg_type == 3)
+        parsed = parse_publish_packet(p, &ssn, mfd->protocol_version);
+    else if (ssn.msg_type == 4)
+        parsed = parse_ack_packet(p, &ssn, mfd->protocol_version);
+
+    if (!parsed || ssn.conformance)
+        return false;
+
+    // Leaves the state alone on a violation, so the full path sees it again
+    if (mfd->proto_state.update(ssn.msg_type, false, p->is_from_client()) != MQTT_SM__OK)
+        return false;
+
+    bool flagged = false;
+
+    // MQTT 5 aliases must still be followed for the PDUs that get sampled,
+    // and the ACL and baselines see every PUBLISH
+    if (ssn.msg_type == 3)
+    {
+        if (mfd->protocol_version == 5)
+            resolve_topic_alias(p, mfd);
+
+        if (topic_baselines)
+            flagged = count_topic(mfd, now_ns);
+
+        if (check_acl(p, mfd))
+            flagged = true;
+    }
+
+    track_keepalive(p, mfd, now_ns);
+    track_heavy_hitters(p, mfd, now_ns);
+
+    if (flagged)
+    {
+        memset(&t, 0, sizeof(t));
+        mqtt_stats.trust_rearmed++;
+        return true;
+    }
+
+    DetectionEngine::disable_all(p);
+
+    mqtt_stats.trust_skipped_pdus++;
+    mqtt_stats.trust_skipped_bytes += p->dsize;
+    return true;
+}
+
+// A connected flow earns trust after trust_after_packets clean PDUs in a
+// row or trust_after_seconds of them; the first unclean PDU takes it away
+void Mqtt::update_trust(Packet* p, MqttFlowData* mfd, bool clean, uint64_t now_ns)
+{
+    mqtt_trust_t& t = mfd->trust;
+
+    if (conf.trust == MQTT_TRUST__OFF)
+        return;
+
+    if (!clean || mfd->proto_state.get_state() != MQTT_CONN_STATE__CONNECTED)
+    {
+        if (t.trusted)
+            mqtt_stats.trust_rearmed++;
+
+        memset(&t, 0, sizeof(t));
+        return;
+    }
+
+    if (t.trusted)
+        return;
+
+    if (!t.clean_pdus++)
+        t.clean_since_ns = now_ns;
+
+    bool earned =
+        (conf.trust_after_packets && t.clean_pdus >= conf.trust_after_packets) ||
+        (conf.trust_after_seconds &&
+            now_ns - t.clean_since_ns >= conf.trust_after_seconds * 1000000000ULL);
+
+    if (!earned)
+        return;
+
+    t.trusted = 1;
+    mqtt_stats.trusted_flows++;
+
+    if (trust_bypass)
+        Stream::stop_inspection(p->flow, p, SSN_DIR_BOTH, -1, 0);
+}
+
+// Takes a token from the bucket of the CONNECT's source; false when the
+// CONNECT was dropped or its flow blocked and needs no further inspection
+bool Mqtt::limit_connect_rate(Packet* p, uint64_t now_ns)
+{
+    if (!connect_limiter || !p->is_from_client())
+        return true;
+
+    const uint8_t* source = reinterpret_cast<const uint8_t*>(p->flow->client_ip.get_ip6_ptr());
+
+    if (connect_limiter->allow(mqtt_distinct_hash(source, MQTT_SOURCE_KEY_LEN), now_ns))
+        return true;
+
+    DetectionEngine::queue_event(GID_MQTT, MQTT_CONNECT_RATE);
+
+    switch (conf.connect_rate_action)
+    {
+    case MQTT_RATE_ACTION__DROP:
+        mqtt_stats.connect_rate_drops++;
+        p->active->drop_packet(p);
+        return false;
+
+    case MQTT_RATE_ACTION__BLOCK:
+        mqtt_stats.connect_rate_blocks++;
+        p->active->block_session(p);
+        return false;
+
+    default:
+        mqtt_stats.connect_rate_alerts++;
+        return true;
+    }
+}
+
+// Estimates the distinct credentials the source of a CONNECT has tried.
+// The password only ever reaches the table as a hash.
+void Mqtt::count_credentials(Packet* p, MqttFlowData* mfd, uint64_t now_ns)
+{
+    mqtt_session_data_t& ssn = mfd->ssn_data;
+
+    if (!sources || !ssn.protocol_version)
+        return;
+
+    uint64_t hashes[MQTT_DISTINCT__MAX] = { };
+
+    if (ssn.username)
+        hashes[MQTT_DISTINCT__USERNAME] = mqtt_distinct_hash(ssn.username, ssn.username_len);
+    if (ssn.password)
+        hashes[MQTT_DISTINCT__PASSWORD] = mqtt_distinct_hash(ssn.password, ssn.passwd_len);
+    if (ssn.client_id)
+        hashes[MQTT_DISTINCT__CLIENT_ID] = mqtt_distinct_hash(ssn.client_id, ssn.client_id_len);
+
+    MqttDistinctCounts counts;
+    sources->add((const uint8_t*)p->flow->client_ip.get_ip6_ptr(), hashes, now_ns, counts);
+
+    ssn.distinct_usernames = counts.count[MQTT_DISTINCT__USERNAME];
+    ssn.distinct_passwords = counts.count[MQTT_DISTINCT__PASSWORD];
+    ssn.distinct_client_ids = counts.count[MQTT_DISTINCT__CLIENT_ID];
+
+    if (counts.crossed & (1 << MQTT_DISTINCT__USERNAME))
+        DetectionEngine::queue_event(GID_MQTT, MQTT_SOURCE_USERNAMES);
+    if (counts.crossed & (1 << MQTT_DISTINCT__PASSWORD))
+        DetectionEngine::queue_event(GID_MQTT, MQTT_SOURCE_PASSWORDS);
+    if (counts.crossed & (1 << MQTT_DISTINCT__CLIENT_ID))
+        DetectionEngine::queue_event(GID_MQTT, MQTT_SOURCE_CLIENT_IDS);
+}
+
+// A client id may only be held by one session; a CONNECT reusing it makes
+// the broker drop the older one. Ids are hashed to 64 bits, so two ids
+// that collide are taken for one.
+void Mqtt::expect_client_id(MqttFlowData* mfd)
+{
+    const mqtt_session_data_t& ssn = mfd->ssn_data;
+
+    if (!registry || !ssn.protocol_version)
+        return;
+
+    mfd->connect_pending = true;
+    mfd->pending_key = ssn.client_id_len ?
+        mqtt_distinct_hash(ssn.client_id, ssn.client_id_len) : 0;
+}
+
+// The client id of a CONNECT only changes hands once the broker accepts it;
+// a refused CONNECT leaves the session with the flow that holds it
+void Mqtt::register_client_id(Packet* p, MqttFlowData* mfd, uint64_t now_ns)
+{
+    mqtt_session_data_t& ssn = mfd->ssn_data;
+    uintptr_t flow = reinterpret_cast<uintptr_t>(mfd);
+
+    if (!mfd->connect_pending || p->is_from_client())
+        return;
+
+    mfd->connect_pending = false;
+    uint64_t key = mfd->pending_key;
+
+    if (ssn.conack_return_code != 0)
+    {
+        if (key && !registry->owns(key, flow))
+        {
+            ssn.client_id_refused_reuse = 1;
+            mqtt_stats.client_id_refused_reuses++;
+        }
+        return;
+    }
+
+    // A repeated CONNECT may name another id; an empty one has the broker assign it
+    if (mfd->registry)
+    {
+        mfd->registry->release(mfd->registry_key, flow);
+        mfd->registry.reset();
+    }
+
+    if (!key)
+        return;
+
+    MqttClientConnect r;
+
+    registry->connect(key, flow, p->flow->client_ip.get_ip6_ptr(), now_ns, r);
+
+    if (r.full)
+    {
+        mqtt_stats.client_registry_full++;
+        return;
+    }
+
+    mfd->registry = registry;
+    mfd->registry_key = key;
+
+    ssn.client_id_replaced = r.replaced;
+    ssn.client_id_takeover = r.takeover;
+    ssn.client_id_switches = r.switches > UINT16_MAX ? UINT16_MAX : r.switches;
+
+    if (r.replaced)
+        mqtt_stats.client_id_replaced++;
+
+    if (r.takeover)
+    {
+        mqtt_stats.client_id_takeovers++;
+        DetectionEngine::queue_event(GID_MQTT, MQTT_CLIENT_ID_TAKEOVER);
+    }
+
+    if (conf.client_id_flap_limit && r.switches == conf.client_id_flap_limit)
+    {
+        mqtt_stats.client_id_flaps++;
+        DetectionEngine::queue_event(GID_MQTT, MQTT_CLIENT_ID_FLAPPING);
+    }
+}
+
+// Counts client PDUs against their source, client id and PUBLISH topic
+void Mqtt::track_heavy_hitters(Packet* p, MqttFlowData* mfd, uint64_t now_ns)
+{
+    if (!mqtt_heavy_hitters)
+        return;
+
+    if (conf.heavy_hitter_interval)
+        mqtt_heavy_hitters->tick(now_ns, conf.heavy_hitter_interval * 1000000000ULL);
+
+    if (!p->is_from_client())
+        return;
+
+    const SfIp& ip = p->flow->client_ip;
+    uint8_t source[MQTT_HH_SOURCE_LEN];
+
+    memcpy(source, ip.get_ip6_ptr(), 16);
+    source[16] = ip.get_family() == AF_INET;
+    mqtt_heavy_hitters->add(MQTT_HH_KEY__SOURCE, source, sizeof(source), p->dsize);
+
+    if (!mfd->acl_client_id.empty())
+        mqtt_heavy_hitters->add(MQTT_HH_KEY__CLIENT_ID,
+            (const uint8_t*)mfd->acl_client_id.data(), mfd->acl_client_id.size(), p->dsize);
+
+    const mqtt_session_data_t& ssn = mfd->ssn_data;
+    if (ssn.msg_type == 3 && ssn.topic_len)
+        mqtt_heavy_hitters->add(MQTT_HH_KEY__TOPIC, ssn.topic, ssn.topic_len, p->dsize);
+}
+
+// Validates a Sparkplug B payload once and publishes one event per metric;
+// rule options walk the metrics again from the cached payload span
+void Mqtt::decode_sparkplug(Packet* p, MqttFlowData* mfd)
+{
+    mqtt_session_data_t& ssn = mfd->ssn_data;
+
+    if (!ssn.topic || !ssn.payload ||
+        !MqttSparkplugReader::is_sparkplug_topic(ssn.topic, ssn.topic_len))
+        return;
+
+    MqttSparkplugReader reader;
+    if (!reader.open(ssn.payload, ssn.payload_len))
+    {
+        mqtt_stats.sparkplug_malformed++;
+        return;
+    }
+
+    ssn.sparkplug = 1;
+    ssn.sparkplug_metrics = reader.metric_count > UINT16_MAX ? UINT16_MAX : reader.metric_count;
+    mqtt_stats.sparkplug_payloads++;
+    mqtt_stats.sparkplug_metrics += reader.metric_count;
+
+    MqttSparkplugMetricEvent me;
+    MqttSparkplugMetric m;
+    unsigned pos = 0;
+    unsigned pub_id = DataBus::get_id(mqtt_pub_key);
+
+    me.seq = reader.seq;
+
+    while (reader.next(pos, m))
+    {
+        me.name = m.name;
+        me.name_len = m.name_len;
+        me.alias = m.alias;
+        me.datatype = m.datatype;
+        me.value_type = m.value_type;
+        me.is_null = m.is_null;
+        me.int_value = m.as_int();
+        me.double_value = m.double_value;
+        me.str = m.str;
+        me.str_len = m.str_len;
+
+        DataBus::publish(pub_id, MqttEventIds::MQTT_SPARKPLUG_METRIC, me, p->flow);
+        me.index++;
+    }
+}
+
+// Wheel callback. The silent flow has no packet in hand, so it is reported
+// on the DataBus right away and SID 7 waits for its next packet, if any.
+static void keepalive_expired(MqttTimer* t, uint64_t now_ns)
+{
+    MqttFlowData* mfd = t->flow;
+    const mqtt_timing_data_t& timing = mfd->timing;
+
+    mfd->timing.keepalive_expired = 1;
+    mqtt_stats.keepalive_expired++;
+
+    MqttKeepaliveExpiredEvent ke;
+    ke.idle_us = now_ns > timing.prev_client_ns ? (now_ns - timing.prev_client_ns) / 1000 : 0;
+    ke.keep_alive = timing.keep_alive;
+
+    DataBus::publish(DataBus::get_id(mqtt_pub_key), MqttEventIds::MQTT_KEEPALIVE_EXPIRY, ke,
+        mfd->flow);
+}
+
+// Re-arms the keep-alive deadline on every client packet and watches for
+// clients that keep stretching their gaps past keep_alive (SlowITe)
+void Mqtt::track_keepalive(Packet* p, MqttFlowData* mfd, uint64_t now_ns)
+{
+    mqtt_timing_data_t& t = mfd->timing;
+
+    if (!p->is_from_client())
+        return;
+
+    if (mfd->ssn_data.msg_type == 1)  // CONNECT
+        t.keep_alive = mfd->ssn_data.keep_alive;
+
+    if (t.prev_client_ns && now_ns >= t.prev_client_ns)
+        t.client_idle_ns = now_ns - t.prev_client_ns;
+    t.prev_client_ns = now_ns;
+
+    if (t.keep_alive == 0 || conf.keepalive_factor <= 0.0 ||
+        mfd->ssn_data.msg_type == 14)  // DISCONNECT
+    {
+        mqtt_keepalive_wheel->cancel(&mfd->keepalive_timer);
+        return;
+    }
+
+    uint64_t keep_alive_ns = t.keep_alive * 1000000000ULL;
+    uint64_t limit_ns = static_cast<uint64_t>(keep_alive_ns * conf.keepalive_factor);
+
+    if (t.client_idle_ns > keep_alive_ns && t.client_idle_ns <= limit_ns)
+    {
+        if (++t.keepalive_overruns == conf.keepalive_trickle_count)
+        {
+            mqtt_stats.keepalive_trickle++;
+            DetectionEngine::queue_event(GID_MQTT, MQTT_KEEPALIVE_TRICKLE);
+        }
+    }
+    else
+        t.keepalive_overruns = 0;
+
+    mqtt_keepalive_wheel->schedule(&mfd->keepalive_timer, now_ns + limit_ns);
+}
+
+void Mqtt::eval(Packet* p)
+{
+    Profile profile(mqtt_prof);   // cppcheck-suppress unreadVariable
+
+    // Preconditions - what we registered for
+    assert(p->has_tcp_data()); // Only called when payload exists
+
+    MqttFlowData* mfd =
+        (MqttFlowData*)p->flow->get_flow_data(MqttFlowData::inspector_id);
+
+    if ( !p->is_full_pdu() )
+    {
+        if ( mfd )
+            mfd->reset();
+
+        // If a packet is rebuilt, but not a full PDU, then it's garbage that
+        // got flushed at the end of a stream.
+        if ( p->packet_flags & (PKT_REBUILT_STREAM|PKT_PDU_HEAD) )
+            DetectionEngine::queue_event(GID_MQTT, MQTT_BAD_LENGTH);
+
+        return;
+    }
 
     if ( !mfd )
     {
-        mfd = new MqttFlowData;
+        mfd = new MqttFlowData(conf);
+        mfd->demand = mqtt_thread_demand;
+        mfd->flow = p->flow;
+        mfd->proto_state.init(p->flow->ssn_state.session_flags & SSNFLAG_MIDSTREAM);
         p->flow->set_flow_data(mfd);
         mqtt_stats.sessions++;
     }
@@ -526,10 +1767,11 @@ void Mqtt::eval(Packet* p)
 
     mqtt_stats.frames++;
 
+    // Cleared even for runt PDUs so the buffer getters never see stale fields
+    mfd->reset();
+
     if (p->dsize < 2)
         return;
-
-    mfd->reset();
     
     struct timeval pkt_time;
     if (p->pkth)
@@ -537,60 +1779,147 @@ void Mqtt::eval(Packet* p)
                      static_cast<suseconds_t>(p->pkth->ts.tv_usec) };
     else
         gettimeofday(&pkt_time, nullptr);
-    mfd->update_timing(pkt_time);
+
+    // Everything downstream works on integer nanoseconds
+    uint64_t now_ns = static_cast<uint64_t>(pkt_time.tv_sec) * 1000000000ULL +
+        static_cast<uint64_t>(pkt_time.tv_usec) * 1000ULL;
+
+    // Expire silent flows first so this flow's own overdue deadline is seen
+    mqtt_keepalive_wheel->advance(now_ns, keepalive_expired);
+
+    uint8_t ka_expired = mfd->timing.keepalive_expired;
+    if (ka_expired)
+    {
+        mfd->timing.keepalive_expired = 0;
+        DetectionEngine::queue_event(GID_MQTT, MQTT_KEEPALIVE_EXPIRED);
+    }
 
     parse_fixed_header(p, &mfd->ssn_data); // Runs for ALL packets
+    mfd->update_timing(now_ns, p->dsize, mfd->ssn_data.msg_type == 3);
     
+    if (trusted_fast_path(p, mfd, now_ns))
+        return;
+
     uint8_t msg_type = mfd->ssn_data.msg_type;
+    uint8_t version = mfd->protocol_version;
+    bool topic_anomaly = false;
 
     switch (msg_type) // Cases based on Table 2.1, 2.2.1 MQTT Control Packet type
     {
     case 1:  // CONNECT
+        if (!limit_connect_rate(p, now_ns))
+            return;
         parse_connect_packet(p, &mfd->ssn_data); // Extracts MORE fields
+        // Every CONNECT replaces the identity, absent fields included
+        mfd->acl_client_id.clear();
+        mfd->acl_username.clear();
+        if (mfd->ssn_data.client_id)
+            mfd->acl_client_id.assign((const char*)mfd->ssn_data.client_id,
+                mfd->ssn_data.client_id_len);
+        if (mfd->ssn_data.username)
+            mfd->acl_username.assign((const char*)mfd->ssn_data.username,
+                mfd->ssn_data.username_len);
+        mfd->acl_identity = true;
+        mfd->acl_generation = 0;
+        count_credentials(p, mfd, now_ns);
+        expect_client_id(mfd);
+        // Later PDUs are laid out by the version the client asked for
+        if (mfd->ssn_data.protocol_version) {
+            mfd->protocol_version = mfd->ssn_data.protocol_version;
+            if (mfd->protocol_version == 5) {
+                mqtt_stats.v5_connects++;
+                // What the client accepts bounds the aliases the server may use
+                mfd->aliases[1].set_maximum(
+                    mfd->ssn_data.props.get_int(MQTT_PROP__TOPIC_ALIAS_MAXIMUM));
+            }
+        }
         break;
         
     case 2:  // CONNACK
-        parse_connack_packet(p, &mfd->ssn_data); // Extracts MORE fields
+        parse_connack_packet(p, &mfd->ssn_data, version); // Extracts MORE fields
+        if (version == 5)
+            mfd->aliases[0].set_maximum(
+                mfd->ssn_data.props.get_int(MQTT_PROP__TOPIC_ALIAS_MAXIMUM));
         if (mfd->ssn_data.conack_return_code != 0) {
-            mfd->record_auth_failure(pkt_time);
+            mfd->record_auth_failure(now_ns);
         }
+        register_client_id(p, mfd, now_ns);
         break;
         
     case 3:  // PUBLISH
-        parse_publish_packet(p, &mfd->ssn_data); // Extracts MORE fields
+        if (!(mfd->demand & MQTT_DEMAND__PUBLISH)) {
+            skim_publish_packet(p, &mfd->ssn_data);
+            mqtt_stats.publish_deferred++;
+        }
+        else if (parse_publish_packet(p, &mfd->ssn_data, version)) {
+            if (version == 5)
+                resolve_topic_alias(p, mfd);
+            topic_anomaly = count_topic(mfd, now_ns);
+            if (conf.sparkplug && (mfd->demand & (MQTT_DEMAND__SPARKPLUG | MQTT_DEMAND__FEATURES)))
+                decode_sparkplug(p, mfd);
+        }
         break;
         
-    case 4:  // PUBACK – NO extra fields
-    case 5:  // PUBREC – NO extra fields
-    case 6:  // PUBREL – NO extra fields
-    case 7:  // PUBCOMP – NO extra fields
-    case 11: // UNSUBACK – NO extra fields
-        parse_ack_packet(p, &mfd->ssn_data); // Extracts MORE fields
+    case 4:  // PUBACK
+    case 5:  // PUBREC
+    case 6:  // PUBREL
+    case 7:  // PUBCOMP
+    case 11: // UNSUBACK
+        parse_ack_packet(p, &mfd->ssn_data, version); // Extracts MORE fields
         break;
         
     case 8:  // SUBSCRIBE
-        parse_subscribe_packet(p, &mfd->ssn_data); // Extracts MORE fields
+        parse_subscribe_packet(p, &mfd->ssn_data, version); // Extracts MORE fields
         break;
         
     case 9:  // SUBACK
-        parse_suback_packet(p, &mfd->ssn_data); // Extracts MORE fields
+        parse_suback_packet(p, &mfd->ssn_data, version); // Extracts MORE fields
         break;
         
     case 10: // UNSUBSCRIBE
-        parse_unsubscribe_packet(p, &mfd->ssn_data); // Extracts MORE fields
+        parse_unsubscribe_packet(p, &mfd->ssn_data, version); // Extracts MORE fields
         break;
         
     case 12: // PINGREQ – NO extra fields, 2 bytes total (fixed header only)
     case 13: // PINGRESP – NO extra fields, 2 bytes total (fixed header only)
-    case 14: // DISCONNECT – NO extra fields, 2 bytes total (fixed header only)
+        break;
+
+    case 14: // DISCONNECT – fixed header only before MQTT 5
+        if (version == 5)
+            parse_reason_packet(p, &mfd->ssn_data);
+        break;
+
+    case 15: // AUTH – MQTT 5 only; accepted on midstream flows of unknown version
+        if (version && version != 5) {
+            DetectionEngine::queue_event(GID_MQTT, MQTT_RESERVED_TYPE);
+            break;
+        }
+        mqtt_stats.auth_packets++;
+        parse_reason_packet(p, &mfd->ssn_data);
         break;
         
     default:
         DetectionEngine::queue_event(GID_MQTT, MQTT_RESERVED_TYPE);
         break;
     }
+
+    raise_conformance_events(mfd->ssn_data.conformance);
+    bool acl_denied = check_acl(p, mfd);
+
+    // Reads the registry without locking, so it can run on every client PDU
+    if (mfd->registry && msg_type != 1 && p->is_from_client())
+        mfd->ssn_data.session_superseded = !mfd->registry->owns(mfd->registry_key,
+            reinterpret_cast<uintptr_t>(mfd));
+
+    mqtt_sm_violation_t violation = check_state(p, mfd);
+    track_qos2(p, mfd, now_ns);
+    track_keepalive(p, mfd, now_ns);
+    track_heavy_hitters(p, mfd, now_ns);
     
-    // Publish comprehensive feature event for ML (every packet)
+    bool anomalous = false;
+
+    // Publish comprehensive feature event for ML (every packet it is wanted for)
+    if (mfd->demand & MQTT_DEMAND__FEATURES)
     {
         MqttFeatureEvent fe;
         
@@ -629,16 +1958,105 @@ void Mqtt::eval(Packet* p)
         // Timing features
         fe.time_delta_us = mfd->get_time_delta_us();
         fe.time_relative_us = mfd->get_time_relative_us();
+
+        // Rate and inter-arrival statistics
+        fe.iat_mean_us = static_cast<float>(mfd->rates.iat_mean_ns / 1000.0);
+        fe.iat_stddev_us = static_cast<float>(mfd->get_iat_stddev_ns() / 1000.0);
+        fe.publish_rate = static_cast<float>(mfd->rates.publish_rate);
+        fe.byte_rate = static_cast<float>(mfd->rates.byte_rate);
+        fe.burstiness = static_cast<float>(mfd->get_burstiness());
         
         // Brute force detection
-        fe.failed_auth_per_second = mfd->get_failed_auth_per_second(pkt_time);
+        fe.failed_auth_per_second = mfd->get_failed_auth_per_second(now_ns);
         fe.failed_auth_count = mfd->timing.failed_auth_count;
         
         // Flow statistics
         fe.pkt_count = mfd->timing.pkt_count;
+
+        // Protocol state machine
+        fe.conn_state = mfd->proto_state.get_state();
+        fe.state_violation = violation;
+        fe.conformance = mfd->ssn_data.conformance;
+
+        // QoS 2 handshake state
+        fe.qos2_inflight = mfd->qos2.get_inflight();
+        fe.qos2_stalled = mfd->qos2.get_stalled();
+        fe.qos2_oldest_age_us = mfd->qos2.get_oldest_age_ns(now_ns) / 1000;
+        fe.qos2_dup_ids = mfd->qos2.get_duplicates();
+
+        // SUBSCRIBE/UNSUBSCRIBE filters
+        fe.filter_count = mfd->ssn_data.filter_count;
+        fe.wildcard_count = mfd->ssn_data.wildcard_count;
+        fe.multilevel_count = mfd->ssn_data.multilevel_count;
+
+        // MQTT 5.0 properties
+        const MqttPropIndex& props = mfd->ssn_data.props;
+        const uint8_t* content_type;
+        uint16_t content_type_len;
+        fe.reason_code = mfd->ssn_data.reason_code;
+        fe.properties_len = props.len;
+        fe.property_count = props.count;
+        fe.user_prop_count = props.user_count;
+        fe.user_prop_bytes = props.user_bytes;
+        fe.topic_alias = props.get_int(MQTT_PROP__TOPIC_ALIAS);
+        fe.session_expiry = props.get_int(MQTT_PROP__SESSION_EXPIRY);
+        fe.message_expiry = props.get_int(MQTT_PROP__MESSAGE_EXPIRY);
+        fe.receive_maximum = props.get_int(MQTT_PROP__RECEIVE_MAXIMUM);
+        if (props.get_string(MQTT_PROP__CONTENT_TYPE, content_type, content_type_len))
+            fe.content_type_len = content_type_len;
+
+        // Keep-alive enforcement
+        fe.idle_us = mfd->timing.client_idle_ns / 1000;
+        fe.keepalive_expired = ka_expired;
+        fe.keepalive_overruns = mfd->timing.keepalive_overruns;
+
+        // Sparkplug B
+        fe.sparkplug_metrics = mfd->ssn_data.sparkplug_metrics;
+
+        // Topic table
+        fe.topic_id = mfd->ssn_data.topic_id;
+        fe.size_zscore = mfd->ssn_data.size_zscore;
+        fe.interval_zscore = mfd->ssn_data.interval_zscore;
+
+        // Source credential churn
+        fe.distinct_usernames = mfd->ssn_data.distinct_usernames;
+        fe.distinct_passwords = mfd->ssn_data.distinct_passwords;
+        fe.distinct_client_ids = mfd->ssn_data.distinct_client_ids;
+
+        // Client id registry
+        fe.client_id_replaced = mfd->ssn_data.client_id_replaced;
+        fe.client_id_takeover = mfd->ssn_data.client_id_takeover;
+        fe.client_id_switches = mfd->ssn_data.client_id_switches;
+        fe.client_id_refused_reuse = mfd->ssn_data.client_id_refused_reuse;
+        fe.session_superseded = mfd->ssn_data.session_superseded;
+
+        // Payload content
+        if (conf.payload_profile && mfd->ssn_data.msg_type == 3 && mfd->ssn_data.payload_len)
+        {
+            static_assert(sizeof(fe.payload_classes) ==
+                MQTT_BYTE_CLASS__MAX * sizeof(fe.payload_classes[0]),
+                "payload_classes must hold every mqtt_byte_class_t");
+
+            MqttPayloadProfile prof;
+            unsigned len = mfd->ssn_data.payload_len < conf.payload_profile_len ?
+                mfd->ssn_data.payload_len : conf.payload_profile_len;
+
+            mqtt_profile_payload(mfd->ssn_data.payload, len, prof);
+            fe.payload_entropy = prof.entropy;
+            fe.payload_printable = prof.printable;
+            memcpy(fe.payload_classes, prof.classes, sizeof(fe.payload_classes));
+            mqtt_stats.payloads_profiled++;
+        }
         
         DataBus::publish(DataBus::get_id(mqtt_pub_key), MqttEventIds::MQTT_FEATURE, fe, p->flow);
+        anomalous = fe.anomalous;
     }
+    else
+        mqtt_stats.features_skipped++;
+
+    update_trust(p, mfd, violation == MQTT_SM__OK && !mfd->ssn_data.conformance &&
+        !anomalous && !ka_expired && !mfd->ssn_data.session_superseded &&
+        !acl_denied && !topic_anomaly, now_ns);
 }
 
 //-------------------------------------------------------------------------
@@ -656,9 +2074,25 @@ static void mqtt_init()
     MqttFlowData::init();
 }
 
-static Inspector* mqtt_ctor(Module*)
+static void mqtt_tinit()
+{
+    mqtt_keepalive_wheel = new MqttTimerWheel(MQTT_KEEPALIVE_TICK_NS);
+    mqtt_filter_arena = new mqtt_filter_span_t[MQTT_FILTER_ARENA_SPANS];
+}
+
+static void mqtt_tterm()
+{
+    delete mqtt_keepalive_wheel;
+    mqtt_keepalive_wheel = nullptr;
+    delete[] mqtt_filter_arena;
+    mqtt_filter_arena = nullptr;
+    MqttAclBinding::thread_term();
+}
+
+static Inspector* mqtt_ctor(Module* m)
 {
-    return new Mqtt;
+    const MqttModule* mod = reinterpret_cast<const MqttModule*>(m);
+    return new Mqtt(mod->get_config());
 }
 
 static void mqtt_dtor(Inspector* p)
@@ -673,6 +2107,13 @@ static const char* mqtt_bufs[] =
     "mqtt_topic",
     "mqtt_payload",
     "mqtt_client_id",
+    "mqtt_content_type",
+    "mqtt_properties",
+    "mqtt_sub_topic",
+    "mqtt_username",
+    "mqtt_will_topic",
+    "mqtt_will_message",
+    "mqtt_payload_decompressed",
     nullptr
 };
 
@@ -696,8 +2137,8 @@ static const InspectApi mqtt_api =
     "mqtt",
     mqtt_init,
     nullptr,
-    nullptr, // tinit
-    nullptr, // tterm
+    mqtt_tinit,
+    mqtt_tterm,
     mqtt_ctor,
     mqtt_dtor,
     nullptr, // ssn
@@ -707,6 +2148,24 @@ static const InspectApi mqtt_api =
 // External IPS option APIs
 extern const BaseApi* ips_mqtt_topic;
 extern const BaseApi* ips_mqtt_payload;
+extern const BaseApi* ips_mqtt_content_type;
+extern const BaseApi* ips_mqtt_properties;
+extern const BaseApi* ips_mqtt_sub_topic;
+extern const BaseApi* ips_mqtt_topic_filter;
+extern const BaseApi* ips_mqtt_client_id;
+extern const BaseApi* ips_mqtt_username;
+extern const BaseApi* ips_mqtt_will_topic;
+extern const BaseApi* ips_mqtt_will_message;
+extern const BaseApi* ips_mqtt_msgtype;
+extern const BaseApi* ips_mqtt_qos;
+extern const BaseApi* ips_mqtt_flags;
+extern const BaseApi* ips_mqtt_remaining_len;
+extern const BaseApi* ips_mqtt_keepalive;
+extern const BaseApi* ips_mqtt_connack;
+extern const BaseApi* ips_mqtt_payload_json;
+extern const BaseApi* ips_mqtt_payload_decompressed;
+extern const BaseApi* ips_mqtt_sparkplug_name;
+extern const BaseApi* ips_mqtt_sparkplug_metric;
 
 #ifdef BUILDING_SO
 SO_PUBLIC const BaseApi* snort_plugins[] =
@@ -717,5 +2176,23 @@ const BaseApi* sin_mqtt[] =
     &mqtt_api.base,
     ips_mqtt_topic,
     ips_mqtt_payload,
+    ips_mqtt_content_type,
+    ips_mqtt_properties,
+    ips_mqtt_sub_topic,
+    ips_mqtt_topic_filter,
+    ips_mqtt_client_id,
+    ips_mqtt_username,
+    ips_mqtt_will_topic,
+    ips_mqtt_will_message,
+    ips_mqtt_msgtype,
+    ips_mqtt_qos,
+    ips_mqtt_flags,
+    ips_mqtt_remaining_len,
+    ips_mqtt_keepalive,
+    ips_mqtt_connack,
+    ips_mqtt_payload_json,
+    ips_mqtt_payload_decompressed,
+    ips_mqtt_sparkplug_name,
+    ips_mqtt_sparkplug_metric,
     nullptr
 };
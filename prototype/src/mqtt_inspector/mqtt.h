@@ -1,18 +1,116 @@
 #ifndef MQTT_H
 #define MQTT_H
 
-#include <sys/time.h>
+#include <cstdint>
+#include <memory>
+#include <string>
 #include "flow/flow.h"
 #include "framework/counts.h"
 
+#include "mqtt_alias.h"
+#include "mqtt_client_registry.h"
+#include "mqtt_module.h"
+#include "mqtt_props.h"
+#include "mqtt_sparkplug.h"
+#include "mqtt_qos2.h"
+#include "mqtt_state.h"
+#include "mqtt_timer.h"
+
 struct MqttStats
 {
     PegCount sessions;
     PegCount frames;
     PegCount concurrent_sessions;
     PegCount max_concurrent_sessions;
+    PegCount qos2_handshakes;
+    PegCount qos2_completed;
+    PegCount qos2_stalled;
+    PegCount qos2_dup_ids;
+    PegCount qos2_unknown_ids;
+    PegCount qos2_table_full;
+    PegCount keepalive_expired;
+    PegCount keepalive_trickle;
+    PegCount state_violations;
+    PegCount suback_mismatches;
+    PegCount bad_flags;
+    PegCount bad_qos;
+    PegCount bad_length_enc;
+    PegCount length_mismatch;
+    PegCount bad_proto_id;
+    PegCount bad_proto_level;
+    PegCount bad_connect_flags;
+    PegCount string_overrun;
+    PegCount bad_property;
+    PegCount v5_connects;
+    PegCount auth_packets;
+    PegCount topic_alias_assigned;
+    PegCount topic_alias_resolved;
+    PegCount topic_alias_errors;
+    PegCount topic_alias_uncached;
+    PegCount acl_publish_denied;
+    PegCount acl_subscribe_denied;
+    PegCount acl_drops;
+    PegCount json_scans;
+    PegCount json_malformed;
+    PegCount decompressed_payloads;
+    PegCount decompressed_bytes;
+    PegCount decompress_cap_hits;
+    PegCount decompress_ratio_hits;
+    PegCount decompress_errors;
+    PegCount sparkplug_payloads;
+    PegCount sparkplug_metrics;
+    PegCount sparkplug_malformed;
+    PegCount bad_utf8;
+    PegCount topics_interned;
+    PegCount topic_evictions;
+    PegCount long_topics;
+    PegCount size_anomalies;
+    PegCount interval_anomalies;
+    PegCount payloads_profiled;
+    PegCount sources_evicted;
+    PegCount client_id_replaced;
+    PegCount client_id_takeovers;
+    PegCount client_id_flaps;
+    PegCount client_id_refused_reuses;
+    PegCount client_registry_full;
+    PegCount connect_rate_alerts;
+    PegCount connect_rate_drops;
+    PegCount connect_rate_blocks;
+    PegCount trusted_flows;
+    PegCount trust_rearmed;
+    PegCount trust_skipped_pdus;
+    PegCount trust_skipped_bytes;
+    PegCount publish_deferred;
+    PegCount publish_parsed_late;
+    PegCount features_skipped;
+};
+
+// Conformance problems found while parsing the current PDU, one bit per check
+enum mqtt_conformance_t : uint32_t
+{
+    MQTT_CONF__BAD_FLAGS         = 0x0001,  // Reserved fixed-header flags, or DUP with QoS 0
+    MQTT_CONF__BAD_QOS           = 0x0002,  // PUBLISH with QoS 3
+    MQTT_CONF__BAD_LENGTH_ENC    = 0x0004,  // Remaining length not minimal or longer than 4 bytes
+    MQTT_CONF__LENGTH_MISMATCH   = 0x0008,  // Remaining length disagrees with the PDU size
+    MQTT_CONF__BAD_PROTO_ID      = 0x0010,  // Protocol name is neither "MQTT" nor "MQIsdp"
+    MQTT_CONF__BAD_PROTO_LEVEL   = 0x0020,  // Protocol level does not go with the name
+    MQTT_CONF__BAD_CONNECT_FLAGS = 0x0040,  // Reserved or contradictory CONNECT flags
+    MQTT_CONF__STRING_OVERRUN    = 0x0080,  // Length-prefixed field runs past the PDU
+    MQTT_CONF__BAD_PROPERTY      = 0x0100,  // Malformed MQTT 5 property block
+    MQTT_CONF__BAD_UTF8          = 0x0200   // Topic, filter, client id or user name not valid UTF-8
+};
+
+// SUBSCRIBE/UNSUBSCRIBE topic filter, located by offset into the PDU
+struct mqtt_filter_span_t
+{
+    uint16_t offset;
+    uint16_t len;
+    uint8_t options;                // SUBSCRIBE options byte, 0 for UNSUBSCRIBE
 };
 
+// Every filter of one PDU fits: an UNSUBSCRIBE entry takes at least 2 bytes
+#define MQTT_FILTER_ARENA_SPANS (65536 / 2)
+
 struct mqtt_session_data_t //naming inspired by modbus:Data extracted from the current PDU (CURRENT message being processed in this session), Reset for EACH new MQTT message, Named "session" because it's the current "work"
 { // every field starts at 0 for each new packet because MqttFlowData::reset() zeroes the entire struct.
     // Phase1, mqtt.hdrflags - Full first byte containing type + flags
@@ -29,6 +127,16 @@ struct mqtt_session_data_t //naming inspired by modbus:Data extracted from the c
     uint32_t remaining_len;
     // Phase1, mqtt.msgid - Message ID (PUBLISH QoS>0, SUBSCRIBE, UNSUBSCRIBE, etc.)
     uint16_t msg_id;
+    // mqtt_conformance_t bits set while parsing this PDU
+    uint32_t conformance;
+
+    // === MQTT 5.0 ===
+    // Properties of the variable header (CONNECT will properties are only validated)
+    MqttPropIndex props;
+    // Reason code of PUBACK/PUBREC/PUBREL/PUBCOMP, UNSUBACK, DISCONNECT and AUTH
+    uint8_t reason_code;
+    // PUBLISH topic came from the alias table, topic points into the flow's copy
+    uint8_t topic_from_alias;
 
     // === CONNECT packet fields ===
     // mqtt.proto_len
@@ -83,7 +191,7 @@ struct mqtt_session_data_t //naming inspired by modbus:Data extracted from the c
     uint8_t conack_session_present;
     // mqtt.conack.flags.reserved (bits 1-7)
     uint8_t conack_reserved;
-    // mqtt.conack.val - Return code
+    // mqtt.conack.val - Return code (reason code in MQTT 5)
     uint8_t conack_return_code;
 
     // === PUBLISH packet fields ===
@@ -95,32 +203,89 @@ struct mqtt_session_data_t //naming inspired by modbus:Data extracted from the c
     const uint8_t* payload;
     // mqtt.msg length
     uint32_t payload_len;
+    // Payload is a well-formed Sparkplug B payload on an spBv1.0 topic
+    uint8_t sparkplug;
+    uint16_t sparkplug_metrics;
+    // Only the packet identifier was read; the rest is parsed when a rule asks
+    uint8_t publish_deferred;
+    // === Source table, CONNECT only ===
+    // Distinct user names, passwords and client ids seen from the source
+    uint32_t distinct_usernames;
+    uint32_t distinct_passwords;
+    uint32_t distinct_client_ids;
 
-    // === SUBSCRIBE packet fields ===
-    // mqtt.sub.qos - Requested QoS values (up to 8 topics)
-    uint8_t sub_qos[8];
-    uint8_t sub_qos_count;
+    // === Client id registry, set on the CONNACK ===
+    // The accepted CONNECT reused a client id another open flow holds, and
+    // from another source
+    uint8_t client_id_replaced;
+    uint8_t client_id_takeover;
+    // Source changes of the client id within the flap window
+    uint16_t client_id_switches;
+    // The refused CONNECT named a client id another open flow holds
+    uint8_t client_id_refused_reuse;
+    // A later CONNECT elsewhere took this flow's client id
+    uint8_t session_superseded;
+
+    // Id in the per-thread topic table, 0 = not interned
+    uint32_t topic_id;
+    // Distance from the topic baselines in standard deviations, 0 until
+    // the baselines have baseline_min_samples
+    float size_zscore;
+    float interval_zscore;
+
+    // === SUBSCRIBE / UNSUBSCRIBE packet fields ===
+    // mqtt.topic - Every topic filter in the request, in the per-thread filter arena
+    const mqtt_filter_span_t* filters;
+    uint16_t filter_count;
+    // Filters using a '+' or '#' wildcard, and those using '#'
+    uint16_t wildcard_count;
+    uint16_t multilevel_count;
 
     // === SUBACK packet fields ===
     // mqtt.suback.qos - Granted QoS values (up to 8 topics)
     uint8_t suback_qos[8];
     uint8_t suback_qos_count;
+    // Number of return codes in the SUBACK, not capped
+    uint16_t suback_code_count;
 };
 
-struct mqtt_timing_data_t
+struct mqtt_timing_data_t // All timestamps are packet time in nanoseconds
 {
-    struct timeval first_pkt_time;
-    struct timeval prev_pkt_time;
+    uint64_t first_pkt_ns;
+    uint64_t prev_pkt_ns;
+    uint64_t last_gap_ns;           // Inter-arrival time before the current PDU
     uint32_t pkt_count;
     uint32_t failed_auth_count;
     uint32_t failed_auth_window_count;
-    struct timeval failed_auth_window_start;
+    uint64_t failed_auth_window_start_ns;
+    uint16_t keep_alive;            // From CONNECT, 0 = client asked for no keep-alive
+    uint8_t keepalive_expired;      // Wheel fired, SID 7 goes out on the flow's next packet
+    uint32_t keepalive_overruns;    // Consecutive client gaps past keep_alive but under the limit
+    uint64_t prev_client_ns;        // Last client-to-server packet
+    uint64_t client_idle_ns;        // Gap before the last client-to-server packet
+};
+
+struct mqtt_trust_t // Earned by staying clean, lost on the first violation
+{
+    uint8_t trusted;
+    uint32_t clean_pdus;            // In a row, while not yet trusted
+    uint64_t clean_since_ns;
+    uint32_t since_sample;          // Trusted PDUs since the last one inspected in full
+};
+
+struct mqtt_rate_stats_t // Online per-flow estimators, each updated in O(1) per PDU
+{
+    double iat_mean_ns;             // EWMA of the inter-arrival time
+    double iat_var_ns2;             // EWMA variance of the inter-arrival time (Welford form)
+    double publish_rate;            // PUBLISH per second, exponentially decayed
+    double byte_rate;               // PDU bytes per second, exponentially decayed
+    uint64_t rate_ns;               // When the decayed rates were last brought forward
 };
 
 class MqttFlowData : public snort::FlowData
 {
 public:
-    MqttFlowData();
+    MqttFlowData(const MqttConfig&);
     ~MqttFlowData() override;
 
     static void init();
@@ -130,22 +295,71 @@ public:
         memset(&ssn_data, 0, sizeof(ssn_data));
     }
 
-    void update_timing(const struct timeval& pkt_time);
+    void update_timing(uint64_t now_ns, uint32_t bytes, bool is_publish);
     int64_t get_time_delta_us() const;
     int64_t get_time_relative_us() const;
-    void record_auth_failure(const struct timeval& pkt_time);
-    float get_failed_auth_per_second(const struct timeval& pkt_time) const;
+    void record_auth_failure(uint64_t now_ns);
+    float get_failed_auth_per_second(uint64_t now_ns) const;
+
+    double get_iat_stddev_ns() const;
+    double get_burstiness() const;
 
 public:
     static unsigned inspector_id;
     mqtt_session_data_t ssn_data;
     mqtt_timing_data_t timing;
+    mqtt_rate_stats_t rates;
+    mqtt_trust_t trust;
+    MqttQos2Tracker qos2;
+    MqttTimer keepalive_timer;
+    MqttProtoState proto_state;
+    uint8_t protocol_version;       // From CONNECT, 0 = not seen (midstream)
+    uint8_t demand;                 // mqtt_demand_t when the flow started, kept for its life
+    snort::Flow* flow;              // Owner, for events raised between its packets
+    MqttTopicAliases aliases[2];    // By sender: 0 = client, 1 = server
+
+    // CONNECT identity kept for the topic ACL, so a reloaded ACL can be
+    // applied to connections that are already up
+    std::string acl_client_id;
+    std::string acl_username;
+    int acl_policy;                 // -1 = unrestricted
+    unsigned acl_generation;        // ACL the policy was looked up in, 0 = none yet
+    bool acl_identity;              // CONNECT seen, identity known
+
+    // Client id this flow holds in the registry, released at flow end
+    std::shared_ptr<MqttClientRegistry> registry;
+    uint64_t registry_key;
+
+    // Client id of a CONNECT waiting for its CONNACK, 0 = none or empty
+    uint64_t pending_key;
+    bool connect_pending;
 };
 
 
+// Fixed-width header fields the numeric rule options test
+enum mqtt_field_t
+{
+    MQTT_FIELD__MSG_TYPE,
+    MQTT_FIELD__QOS,
+    MQTT_FIELD__FLAGS,              // Low nibble of the first byte
+    MQTT_FIELD__REMAINING_LEN,
+    MQTT_FIELD__KEEPALIVE,          // CONNECT only
+    MQTT_FIELD__CONNACK_CODE        // CONNACK only
+};
+
 extern THREAD_LOCAL MqttStats mqtt_stats;
 bool get_buf_mqtt_topic(snort::Packet* p, snort::InspectionBuffer& b);
 bool get_buf_mqtt_payload(snort::Packet* p, snort::InspectionBuffer& b);
+bool get_buf_mqtt_payload_decompressed(snort::Packet* p, snort::InspectionBuffer& b);
 bool get_buf_mqtt_client_id(snort::Packet* p, snort::InspectionBuffer& b);
+bool get_buf_mqtt_username(snort::Packet* p, snort::InspectionBuffer& b);
+bool get_buf_mqtt_will_topic(snort::Packet* p, snort::InspectionBuffer& b);
+bool get_buf_mqtt_will_message(snort::Packet* p, snort::InspectionBuffer& b);
+bool get_buf_mqtt_content_type(snort::Packet* p, snort::InspectionBuffer& b);
+bool get_buf_mqtt_properties(snort::Packet* p, snort::InspectionBuffer& b);
+unsigned get_mqtt_sub_topic_count(snort::Packet* p);
+bool get_buf_mqtt_sub_topic(snort::Packet* p, unsigned index, snort::InspectionBuffer& b);
+bool get_mqtt_field(snort::Packet* p, mqtt_field_t field, uint32_t& value);
+bool get_mqtt_sparkplug(snort::Packet* p, MqttSparkplugReader& reader);
 
 #endif
\ No newline at end of file
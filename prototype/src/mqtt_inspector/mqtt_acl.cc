@@ -0,0 +1,407 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_acl.cc author Zhinoo Zobairi
+// Topic access policy per MQTT client identity.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mqtt_acl.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+#include "log/messages.h"
+#include "main/thread.h"
+
+using namespace snort;
+
+//-------------------------------------------------------------------------
+// bindings
+//-------------------------------------------------------------------------
+
+// Live bindings by slot, null = free
+static std::mutex bindings_lock;
+static std::vector<MqttAclBinding*> bindings;
+
+// Shared by all bindings so a generation is never seen twice on a thread
+static std::atomic<unsigned> generations { 0 };
+
+// What one packet thread uses of one binding. The counts are only touched
+// by the owning thread, so the hot path shares no cache lines.
+struct AclSnapshot
+{
+    unsigned generation = 0;
+    std::shared_ptr<const MqttAcl> acl;
+    std::string path;
+    std::vector<uint64_t> checks;   // Per policy of acl
+    std::vector<uint64_t> denied;
+};
+
+// By binding slot
+static THREAD_LOCAL std::vector<AclSnapshot>* acl_snapshots = nullptr;
+
+static AclSnapshot& get_snapshot(unsigned slot)
+{
+    if (!acl_snapshots)
+        acl_snapshots = new std::vector<AclSnapshot>;
+
+    if (acl_snapshots->size() <= slot)
+        acl_snapshots->resize(slot + 1);
+
+    return (*acl_snapshots)[slot];
+}
+
+MqttAclBinding::MqttAclBinding(std::shared_ptr<const MqttAcl> a, const std::string& p) :
+    path(p), acl(std::move(a)), generation(generations.fetch_add(1) + 1)
+{
+    std::lock_guard<std::mutex> guard(bindings_lock);
+
+    auto it = std::find(bindings.begin(), bindings.end(), nullptr);
+    slot = it - bindings.begin();
+
+    if (it == bindings.end())
+        bindings.push_back(this);
+    else
+        *it = this;
+}
+
+MqttAclBinding::~MqttAclBinding()
+{
+    std::lock_guard<std::mutex> guard(bindings_lock);
+    bindings[slot] = nullptr;
+}
+
+void MqttAclBinding::set(std::shared_ptr<const MqttAcl> a)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    acl = std::move(a);
+    generation.store(generations.fetch_add(1) + 1, std::memory_order_release);
+}
+
+const MqttAcl* MqttAclBinding::get(unsigned& gen) const
+{
+    AclSnapshot& s = get_snapshot(slot);
+
+    // The lock is only taken when a new ACL was set since the last look
+    if (generation.load(std::memory_order_acquire) != s.generation)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        s.acl = acl;
+        s.path = path;
+        s.generation = generation.load(std::memory_order_relaxed);
+        s.checks.assign(acl ? acl->size() : 0, 0);
+        s.denied.assign(acl ? acl->size() : 0, 0);
+    }
+
+    gen = s.generation;
+    return s.acl.get();
+}
+
+void MqttAclBinding::count(int policy, bool allowed) const
+{
+    AclSnapshot& s = (*acl_snapshots)[slot];
+
+    s.checks[policy]++;
+    if (!allowed)
+        s.denied[policy]++;
+}
+
+void MqttAclBinding::thread_release() const
+{
+    if (acl_snapshots && slot < acl_snapshots->size())
+        (*acl_snapshots)[slot] = AclSnapshot();
+}
+
+void MqttAclBinding::thread_term()
+{
+    delete acl_snapshots;
+    acl_snapshots = nullptr;
+}
+
+// Packet threads pick up the new ACLs on their next PDU
+void MqttAclBinding::reload_all()
+{
+    std::lock_guard<std::mutex> guard(bindings_lock);
+    bool configured = false;
+
+    for (MqttAclBinding* b : bindings)
+    {
+        if (!b || b->path.empty())
+            continue;
+
+        configured = true;
+
+        std::string error;
+        std::shared_ptr<const MqttAcl> acl = MqttAcl::load(b->path, error);
+        if (!acl)
+        {
+            ErrorMessage("mqtt: ACL not reloaded: %s\n", error.c_str());
+            continue;
+        }
+
+        LogMessage("mqtt: reloaded %u ACL policies from %s\n", acl->size(), b->path.c_str());
+        b->set(acl);
+    }
+
+    if (!configured)
+        LogMessage("mqtt: no acl_file configured\n");
+}
+
+//-------------------------------------------------------------------------
+// stats command
+//-------------------------------------------------------------------------
+
+bool MqttAclStatsCommand::execute(Analyzer&, void**)
+{
+    if (!acl_snapshots)
+        return true;
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    for (const AclSnapshot& s : *acl_snapshots)
+    {
+        if (!s.acl)
+            continue;
+
+        Totals& t = totals[s.acl.get()];
+
+        if (!t.acl)
+        {
+            t.acl = s.acl;
+            t.path = s.path;
+            t.checks.assign(s.acl->size(), 0);
+            t.denied.assign(s.acl->size(), 0);
+        }
+
+        for (unsigned i = 0; i < s.acl->size(); i++)
+        {
+            t.checks[i] += s.checks[i];
+            t.denied[i] += s.denied[i];
+        }
+    }
+    return true;
+}
+
+MqttAclStatsCommand::~MqttAclStatsCommand()
+{
+    if (totals.empty())
+    {
+        LogMessage("mqtt: no ACL loaded\n");
+        return;
+    }
+
+    for (const auto& entry : totals)
+    {
+        const Totals& t = entry.second;
+        LogMessage("mqtt acl %s:\n", t.path.c_str());
+
+        for (unsigned i = 0; i < t.acl->size(); i++)
+        {
+            LogMessage("  %s: checks %" PRIu64 ", denied %" PRIu64 "\n",
+                t.acl->get_policy(i).name.c_str(), t.checks[i], t.denied[i]);
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+// loading
+//-------------------------------------------------------------------------
+
+std::shared_ptr<const MqttAcl> MqttAcl::load(const std::string& path, std::string& error)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        error = "can't open " + path;
+        return nullptr;
+    }
+
+    auto acl = std::make_shared<MqttAcl>();
+    std::string line;
+    unsigned line_num = 0;
+
+    while (std::getline(file, line))
+    {
+        line_num++;
+
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+            continue;
+
+        if (!acl->add_rule(line, error))
+        {
+            error = path + ":" + std::to_string(line_num) + ": " + error;
+            return nullptr;
+        }
+    }
+
+    for (auto& policy : acl->policies)
+    {
+        policy->publish.compile();
+        policy->subscribe.compile();
+    }
+
+    for (Identities* ids : { &acl->clients, &acl->users })
+    {
+        std::stable_sort(ids->prefixes.begin(), ids->prefixes.end(),
+            [](const std::pair<std::string, int>& a, const std::pair<std::string, int>& b)
+            { return a.first.size() > b.first.size(); });
+    }
+
+    return acl;
+}
+
+bool MqttAcl::add_rule(const std::string& line, std::string& error)
+{
+    std::istringstream in(line);
+    std::string kind, identity, access, filter;
+
+    if (!(in >> kind >> identity >> access))
+    {
+        error = "expected <client|user> <identity> <publish|subscribe|any> <filter> ...";
+        return false;
+    }
+
+    Identities* ids;
+    if (kind == "client")
+        ids = &clients;
+    else if (kind == "user")
+        ids = &users;
+    else
+    {
+        error = "unknown identity kind '" + kind + "'";
+        return false;
+    }
+
+    bool publish = (access == "publish" || access == "any");
+    bool subscribe = (access == "subscribe" || access == "any");
+    if (!publish && !subscribe)
+    {
+        error = "unknown access '" + access + "'";
+        return false;
+    }
+
+    // Find or create the policy of this identity
+    bool prefix = (identity.back() == '*');
+    std::string key = prefix ? identity.substr(0, identity.size() - 1) : identity;
+    int index = -1;
+
+    if (prefix)
+    {
+        for (const auto& p : ids->prefixes)
+        {
+            if (p.first == key)
+                index = p.second;
+        }
+    }
+    else
+    {
+        auto it = ids->exact.find(key);
+        if (it != ids->exact.end())
+            index = it->second;
+    }
+
+    if (index < 0)
+    {
+        index = policies.size();
+        policies.emplace_back(new MqttAclPolicy);
+        policies.back()->name = kind + " " + identity;
+
+        if (prefix)
+            ids->prefixes.emplace_back(key, index);
+        else
+            ids->exact.emplace(key, index);
+    }
+
+    MqttAclPolicy& policy = *policies[index];
+    unsigned filters = 0;
+
+    while (in >> filter)
+    {
+        if (!MqttTopicTrie::valid_filter(filter.c_str(), filter.size()))
+        {
+            error = "invalid topic filter '" + filter + "'";
+            return false;
+        }
+        if (publish)
+            policy.publish.add(filter.c_str(), filter.size());
+        if (subscribe)
+            policy.subscribe.add(filter.c_str(), filter.size());
+        filters++;
+    }
+
+    if (!filters)
+    {
+        error = "no topic filters";
+        return false;
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------------
+// lookup
+//-------------------------------------------------------------------------
+
+int MqttAcl::Identities::find(const std::string& id) const
+{
+    auto it = exact.find(id);
+    if (it != exact.end())
+        return it->second;
+
+    for (const auto& p : prefixes)
+    {
+        if (id.compare(0, p.first.size(), p.first) == 0)
+            return p.second;
+    }
+    return -1;
+}
+
+int MqttAcl::find_policy(const std::string& client_id, const std::string& username) const
+{
+    int policy = -1;
+
+    if (!username.empty())
+        policy = users.find(username);
+
+    if (policy < 0)
+        policy = clients.find(client_id);
+
+    return policy;
+}
+
+bool MqttAcl::allow_publish(int policy, const uint8_t* topic, unsigned len) const
+{
+    if (policy < 0 || !policies[policy]->publish.size())
+        return true;
+
+    return policies[policy]->publish.match_any(topic, len);
+}
+
+bool MqttAcl::allow_subscribe(int policy, const uint8_t* filter, unsigned len) const
+{
+    if (policy < 0 || !policies[policy]->subscribe.size())
+        return true;
+
+    return policies[policy]->subscribe.covers(filter, len);
+}
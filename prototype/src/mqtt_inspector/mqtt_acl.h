@@ -0,0 +1,152 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_acl.h author Zhinoo Zobairi
+// Topic access policy per MQTT client identity.
+
+#ifndef MQTT_ACL_H
+#define MQTT_ACL_H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "main/analyzer_command.h"
+
+#include "mqtt_topic_trie.h"
+
+// What one client identity may publish and subscribe to
+struct MqttAclPolicy
+{
+    std::string name;               // "<client|user> <identity>" as written in the file
+    MqttTopicTrie publish;
+    MqttTopicTrie subscribe;
+};
+
+// Policy file, one rule per line, '#' starts a comment:
+//
+//   <client|user> <identity> <publish|subscribe|any> <filter> [<filter> ...]
+//
+// An identity ending in '*' is a prefix, "*" alone matches everyone. Lines
+// for the same identity add to the same policy. A connection gets the
+// policy of its user name if there is one, else that of its client id;
+// an exact identity beats a prefix and a longer prefix a shorter one.
+// Connections no policy applies to are not restricted, and neither is a
+// direction a policy has no rules for: "publish" lines alone leave the
+// identity free to subscribe.
+//
+// A loaded ACL is immutable; see MqttAclBinding for how it is replaced.
+class MqttAcl
+{
+public:
+    // Null with error set when the file cannot be read or parsed
+    static std::shared_ptr<const MqttAcl> load(const std::string& path, std::string& error);
+
+    // Index of the policy for a CONNECT identity, -1 = unrestricted
+    int find_policy(const std::string& client_id, const std::string& username) const;
+
+    bool allow_publish(int policy, const uint8_t* topic, unsigned len) const;
+    bool allow_subscribe(int policy, const uint8_t* filter, unsigned len) const;
+
+    unsigned size() const
+    { return policies.size(); }
+
+    const MqttAclPolicy& get_policy(unsigned i) const
+    { return *policies[i]; }
+
+private:
+    struct Identities
+    {
+        std::unordered_map<std::string, int> exact;
+        std::vector<std::pair<std::string, int>> prefixes;  // Longest first
+
+        int find(const std::string&) const;
+    };
+
+    Identities clients;
+    Identities users;
+    std::vector<std::unique_ptr<MqttAclPolicy>> policies;
+
+    bool add_rule(const std::string& line, std::string& error);
+};
+
+// The ACL of one mqtt inspector, so inspectors of different policies each
+// enforce their own file. reload_acl swaps a new ACL in whole; packet
+// threads keep the snapshot they hold until they next look for a newer one.
+class MqttAclBinding
+{
+public:
+    MqttAclBinding(std::shared_ptr<const MqttAcl>, const std::string& path);
+    ~MqttAclBinding();
+
+    // This thread's snapshot, refreshed when a new ACL was set; generation
+    // changes whenever the snapshot does and is never reused
+    const MqttAcl* get(unsigned& generation) const;
+
+    // Counts a check against a policy of this thread's snapshot
+    void count(int policy, bool allowed) const;
+
+    // Drops this thread's snapshot
+    void thread_release() const;
+
+    // Reloads the file of every binding; one that does not load keeps its ACL
+    static void reload_all();
+
+    // Frees what the calling thread holds for all bindings
+    static void thread_term();
+
+private:
+    std::string path;
+    unsigned slot;                  // Index of this thread's snapshot
+    mutable std::mutex lock;
+    std::shared_ptr<const MqttAcl> acl;
+    std::atomic<unsigned> generation;
+
+    void set(std::shared_ptr<const MqttAcl>);
+};
+
+// Sums the checks and denials each packet thread counted per ACL policy
+class MqttAclStatsCommand : public snort::AnalyzerCommand
+{
+public:
+    ~MqttAclStatsCommand() override;
+
+    bool execute(snort::Analyzer&, void**) override;
+
+    const char* stringify() override
+    { return "MQTT_ACL_STATS"; }
+
+private:
+    struct Totals
+    {
+        std::string path;
+        std::shared_ptr<const MqttAcl> acl;
+        std::vector<uint64_t> checks;   // Per policy
+        std::vector<uint64_t> denied;
+    };
+
+    std::mutex lock;
+    std::map<const MqttAcl*, Totals> totals;
+};
+
+#endif
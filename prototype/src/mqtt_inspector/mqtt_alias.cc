@@ -0,0 +1,113 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_alias.cc author Zhinoo Zobairi
+// MQTT 5.0 topic alias table.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mqtt_alias.h"
+
+#include <cstring>
+
+// Slot length of an alias whose topic was too long to keep
+#define ALIAS_NOT_KEPT 0xFFFF
+
+MqttTopicAliases::MqttTopicAliases(uint32_t entries, uint32_t len) :
+    max_entries(entries), max_len(len)
+{ }
+
+MqttTopicAliases::~MqttTopicAliases()
+{
+    delete[] pool;
+    delete[] lens;
+}
+
+void MqttTopicAliases::set_maximum(uint16_t negotiated_max)
+{
+    maximum = negotiated_max;
+    negotiated = true;
+}
+
+mqtt_alias_result_t MqttTopicAliases::check(uint16_t alias) const
+{
+    if (alias == 0 || (negotiated && alias > maximum))
+        return MQTT_ALIAS_RESULT__OUT_OF_RANGE;
+
+    if (alias > max_entries)
+        return MQTT_ALIAS_RESULT__NOT_CACHED;
+
+    return MQTT_ALIAS_RESULT__OK;
+}
+
+mqtt_alias_result_t MqttTopicAliases::assign(uint16_t alias, const uint8_t* topic, uint16_t len)
+{
+    mqtt_alias_result_t r = check(alias);
+    if (r != MQTT_ALIAS_RESULT__OK)
+        return r;
+
+    if (!pool)
+    {
+        // Sized once: by the announced maximum when there was one, else by
+        // the configured limit
+        capacity = (negotiated && maximum < max_entries) ? maximum : max_entries;
+        pool = new uint8_t[capacity * max_len];
+        lens = new uint16_t[capacity];
+        memset(lens, 0, capacity * sizeof(*lens));
+    }
+
+    if (alias > capacity)
+        return MQTT_ALIAS_RESULT__NOT_CACHED;
+
+    // A topic too long to keep also drops the old mapping, so the alias
+    // does not resolve to something the sender has replaced
+    if (len > max_len)
+    {
+        lens[alias - 1] = ALIAS_NOT_KEPT;
+        return MQTT_ALIAS_RESULT__NOT_CACHED;
+    }
+
+    memcpy(pool + (alias - 1) * max_len, topic, len);
+    lens[alias - 1] = len;
+    return MQTT_ALIAS_RESULT__OK;
+}
+
+mqtt_alias_result_t MqttTopicAliases::resolve(uint16_t alias, const uint8_t*& topic,
+    uint16_t& len) const
+{
+    mqtt_alias_result_t r = check(alias);
+    if (r != MQTT_ALIAS_RESULT__OK)
+        return r;
+
+    // Nothing assigned yet, so the table has not been sized either
+    if (!pool)
+        return negotiated ? MQTT_ALIAS_RESULT__UNKNOWN : MQTT_ALIAS_RESULT__NOT_CACHED;
+
+    if (alias > capacity || lens[alias - 1] == ALIAS_NOT_KEPT)
+        return MQTT_ALIAS_RESULT__NOT_CACHED;
+
+    // Only a table that saw the connection start has seen every assignment
+    if (lens[alias - 1] == 0)
+        return negotiated ? MQTT_ALIAS_RESULT__UNKNOWN : MQTT_ALIAS_RESULT__NOT_CACHED;
+
+    topic = pool + (alias - 1) * max_len;
+    len = lens[alias - 1];
+    return MQTT_ALIAS_RESULT__OK;
+}
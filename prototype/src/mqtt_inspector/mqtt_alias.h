@@ -0,0 +1,64 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_alias.h author Zhinoo Zobairi
+// MQTT 5.0 topic alias table (MQTT 5.0 section 3.3.2.3.4).
+
+#ifndef MQTT_ALIAS_H
+#define MQTT_ALIAS_H
+
+#include <cstdint>
+
+enum mqtt_alias_result_t : uint8_t
+{
+    MQTT_ALIAS_RESULT__OK,
+    MQTT_ALIAS_RESULT__OUT_OF_RANGE,    // Alias 0 or above the negotiated maximum
+    MQTT_ALIAS_RESULT__UNKNOWN,         // Empty topic with an alias never assigned
+    MQTT_ALIAS_RESULT__NOT_CACHED       // Legal, but past our entry or length limits
+};
+
+// Aliases one side of the connection has assigned. The Topic Alias Maximum
+// the receiver announced bounds the legal range; the configured limits
+// bound what is kept. Storage is allocated on the first assignment and
+// never resized: slot i holds alias i + 1, so a topic is copied once when
+// it is assigned and resolved without copying after that.
+class MqttTopicAliases
+{
+public:
+    MqttTopicAliases(uint32_t max_entries, uint32_t max_len);
+    ~MqttTopicAliases();
+
+    // Topic Alias Maximum from the peer's CONNECT or CONNACK
+    void set_maximum(uint16_t negotiated);
+
+    mqtt_alias_result_t assign(uint16_t alias, const uint8_t* topic, uint16_t len);
+    mqtt_alias_result_t resolve(uint16_t alias, const uint8_t*& topic, uint16_t& len) const;
+
+private:
+    uint8_t* pool = nullptr;        // capacity slots of max_len bytes
+    uint16_t* lens = nullptr;       // Topic length per slot, 0 = unassigned
+    uint16_t max_entries;
+    uint16_t max_len;
+    uint16_t capacity = 0;
+    uint16_t maximum = 0;
+    bool negotiated = false;        // False on midstream pickup: range is not checked
+
+    mqtt_alias_result_t check(uint16_t alias) const;
+};
+
+#endif
@@ -0,0 +1,201 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_cardinality.cc author Zhinoo Zobairi
+// HyperLogLog counts of distinct CONNECT credentials per source address.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mqtt_cardinality.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "mqtt.h"
+
+//-------------------------------------------------------------------------
+// HyperLogLog
+//-------------------------------------------------------------------------
+
+uint64_t mqtt_distinct_hash(const uint8_t* data, unsigned len)
+{
+    // FNV-1a, then the splitmix64 finalizer so every bit is well mixed
+    uint64_t h = 14695981039346656037ULL;
+    for (unsigned i = 0; i < len; i++)
+    {
+        h ^= data[i];
+        h *= 1099511628211ULL;
+    }
+
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+
+    // 0 means absent to the table
+    return h ? h : 1;
+}
+
+void MqttHyperLogLog::add(uint64_t hash)
+{
+    unsigned idx = hash >> (64 - MQTT_HLL_BITS);
+    uint64_t rest = hash << MQTT_HLL_BITS;
+
+    // Position of the first 1 bit in the remaining bits
+    uint8_t rank = rest ? __builtin_clzll(rest) + 1 : 64 - MQTT_HLL_BITS + 1;
+
+    if (rank > reg[idx])
+        reg[idx] = rank;
+}
+
+double MqttHyperLogLog::estimate() const
+{
+    const double m = MQTT_HLL_REGISTERS;
+    const double alpha = 0.7213 / (1.0 + 1.079 / m);
+
+    double sum = 0.0;
+    unsigned zeros = 0;
+
+    for (unsigned i = 0; i < MQTT_HLL_REGISTERS; i++)
+    {
+        sum += std::ldexp(1.0, -reg[i]);
+        if (!reg[i])
+            zeros++;
+    }
+
+    double e = alpha * m * m / sum;
+
+    // Linear counting is more accurate while registers are still empty
+    if (e <= 2.5 * m && zeros)
+        e = m * std::log(m / zeros);
+
+    return e;
+}
+
+//-------------------------------------------------------------------------
+// source table
+//-------------------------------------------------------------------------
+
+void MqttSourceTable::Shard::unlink(uint32_t i)
+{
+    Entry& e = entries[i - 1];
+
+    if (e.prev)
+        entries[e.prev - 1].next = e.next;
+    else
+        head = e.next;
+
+    if (e.next)
+        entries[e.next - 1].prev = e.prev;
+    else
+        tail = e.prev;
+
+    e.prev = e.next = 0;
+}
+
+void MqttSourceTable::Shard::push_front(uint32_t i)
+{
+    Entry& e = entries[i - 1];
+
+    e.prev = 0;
+    e.next = head;
+
+    if (head)
+        entries[head - 1].prev = i;
+    else
+        tail = i;
+
+    head = i;
+}
+
+MqttSourceTable::MqttSourceTable(unsigned capacity, uint32_t window_s, const uint32_t* l)
+{
+    shard_capacity = (capacity + MQTT_SOURCE_SHARDS - 1) / MQTT_SOURCE_SHARDS;
+    window_ns = window_s * 1000000000ULL;
+    memcpy(limits, l, sizeof(limits));
+
+    for (Shard& s : shards)
+    {
+        s.entries.reserve(shard_capacity);
+        s.index.reserve(shard_capacity);
+    }
+}
+
+void MqttSourceTable::add(const uint8_t* source, const uint64_t* hashes, uint64_t now_ns,
+    MqttDistinctCounts& out)
+{
+    uint64_t key_hash = mqtt_distinct_hash(source, MQTT_SOURCE_KEY_LEN);
+    Shard& s = shards[key_hash % MQTT_SOURCE_SHARDS];
+
+    std::lock_guard<std::mutex> guard(s.lock);
+
+    uint32_t i = 0;
+    auto it = s.index.find(key_hash);
+
+    // Two sources with the same 64-bit hash share one entry
+    if (it != s.index.end())
+    {
+        i = it->second;
+        s.unlink(i);
+    }
+    else if (s.entries.size() < shard_capacity)
+    {
+        s.entries.emplace_back();
+        i = s.entries.size();
+    }
+    else
+    {
+        i = s.tail;
+        s.unlink(i);
+        s.index.erase(mqtt_distinct_hash(s.entries[i - 1].key, MQTT_SOURCE_KEY_LEN));
+        mqtt_stats.sources_evicted++;
+    }
+
+    Entry& e = s.entries[i - 1];
+
+    if (it == s.index.end() || now_ns > e.last_seen_ns + window_ns)
+    {
+        memcpy(e.key, source, MQTT_SOURCE_KEY_LEN);
+        memset(e.hll, 0, sizeof(e.hll));
+        e.alerted = 0;
+        s.index[key_hash] = i;
+    }
+
+    e.last_seen_ns = now_ns;
+    s.push_front(i);
+
+    out.crossed = 0;
+
+    for (unsigned d = 0; d < MQTT_DISTINCT__MAX; d++)
+    {
+        if (hashes[d])
+            e.hll[d].add(hashes[d]);
+
+        double est = e.hll[d].estimate();
+        out.count[d] = est > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(est + 0.5);
+
+        if (limits[d] && out.count[d] > limits[d] && !(e.alerted & (1 << d)))
+        {
+            e.alerted |= 1 << d;
+            out.crossed |= 1 << d;
+        }
+    }
+}
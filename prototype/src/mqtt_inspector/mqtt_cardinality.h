@@ -0,0 +1,107 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_cardinality.h author Zhinoo Zobairi
+// HyperLogLog counts of distinct CONNECT credentials per source address.
+
+#ifndef MQTT_CARDINALITY_H
+#define MQTT_CARDINALITY_H
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// 2^8 registers give a standard error of about 6.5%
+#define MQTT_HLL_BITS 8
+#define MQTT_HLL_REGISTERS (1 << MQTT_HLL_BITS)
+
+// Independent table shards, each with its own lock
+#define MQTT_SOURCE_SHARDS 16
+
+// Source keys are the IPv6 (or mapped IPv4) address
+#define MQTT_SOURCE_KEY_LEN 16
+
+enum mqtt_distinct_t : uint8_t
+{
+    MQTT_DISTINCT__USERNAME,
+    MQTT_DISTINCT__PASSWORD,        // Only the hash is ever seen by the table
+    MQTT_DISTINCT__CLIENT_ID,
+    MQTT_DISTINCT__MAX
+};
+
+struct MqttHyperLogLog
+{
+    uint8_t reg[MQTT_HLL_REGISTERS];
+
+    void add(uint64_t hash);
+    double estimate() const;
+};
+
+// 64-bit hash for the estimators; strings only pass through it
+uint64_t mqtt_distinct_hash(const uint8_t* data, unsigned len);
+
+struct MqttDistinctCounts
+{
+    uint32_t count[MQTT_DISTINCT__MAX];
+    uint8_t crossed;                // Bit per mqtt_distinct_t newly past its limit
+};
+
+// Distinct usernames, password hashes and client ids seen in CONNECTs of
+// each source, shared by all packet threads. The table holds a fixed number
+// of sources split over shards; the least recently seen source of a full
+// shard is replaced, and a source silent for a whole window starts over.
+class MqttSourceTable
+{
+public:
+    MqttSourceTable(unsigned capacity, uint32_t window_s, const uint32_t* limits);
+
+    // hashes holds one mqtt_distinct_hash per mqtt_distinct_t, 0 = absent
+    void add(const uint8_t* source, const uint64_t* hashes, uint64_t now_ns,
+        MqttDistinctCounts& out);
+
+private:
+    struct Entry
+    {
+        uint8_t key[MQTT_SOURCE_KEY_LEN];
+        uint64_t last_seen_ns;
+        uint32_t prev;              // LRU list, index + 1, 0 = none
+        uint32_t next;
+        uint8_t alerted;            // Bit per mqtt_distinct_t already reported
+        MqttHyperLogLog hll[MQTT_DISTINCT__MAX];
+    };
+
+    struct Shard
+    {
+        std::mutex lock;
+        std::unordered_map<uint64_t, uint32_t> index;   // Key hash to entry index
+        std::vector<Entry> entries;
+        uint32_t head = 0;
+        uint32_t tail = 0;
+
+        void unlink(uint32_t);
+        void push_front(uint32_t);
+    };
+
+    Shard shards[MQTT_SOURCE_SHARDS];
+    unsigned shard_capacity;
+    uint64_t window_ns;
+    uint32_t limits[MQTT_DISTINCT__MAX];
+};
+
+#endif
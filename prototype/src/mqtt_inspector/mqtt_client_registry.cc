@@ -0,0 +1,212 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_client_registry.cc author Zhinoo Zobairi
+// Client ids in use across all flows, for session takeover detection.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mqtt_client_registry.h"
+
+#include <cstring>
+
+MqttClientRegistry::MqttClientRegistry(unsigned capacity, uint32_t flap_window_s)
+{
+    shard_limit = (capacity + MQTT_REGISTRY_SHARDS - 1) / MQTT_REGISTRY_SHARDS;
+    flap_window_ns = flap_window_s * 1000000000ULL;
+
+    // At most half of the slots are ever used, so probes stay short
+    uint32_t size = 2;
+    while (size < 2 * shard_limit)
+        size <<= 1;
+
+    for (Shard& s : shards)
+    {
+        s.slots.reset(new Slot[size]);
+        s.mask = size - 1;
+
+        for (uint32_t i = 0; i < size; i++)
+        {
+            for (auto& w : s.slots[i].word)
+                w.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void MqttClientRegistry::load(const Slot& s, Entry& e)
+{
+    uint64_t* w = reinterpret_cast<uint64_t*>(&e);
+
+    for (unsigned i = 0; i < sizeof(Entry) / sizeof(uint64_t); i++)
+        w[i] = s.word[i].load(std::memory_order_relaxed);
+}
+
+void MqttClientRegistry::store(Slot& s, const Entry& e)
+{
+    const uint64_t* w = reinterpret_cast<const uint64_t*>(&e);
+
+    for (unsigned i = 0; i < sizeof(Entry) / sizeof(uint64_t); i++)
+        s.word[i].store(w[i], std::memory_order_relaxed);
+}
+
+void MqttClientRegistry::write_begin(Shard& s)
+{
+    s.seq.store(s.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void MqttClientRegistry::write_end(Shard& s)
+{
+    s.seq.store(s.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// Bounded, since a reader may see the table mid-change
+int MqttClientRegistry::find(const Shard& s, uint64_t key) const
+{
+    uint32_t i = key & s.mask;
+
+    for (uint32_t n = 0; n <= s.mask; n++)
+    {
+        uint64_t k = get_key(s.slots[i]);
+
+        if (k == key)
+            return i;
+        if (!k)
+            break;
+
+        i = (i + 1) & s.mask;
+    }
+    return -1;
+}
+
+bool MqttClientRegistry::owns(uint64_t key, uint64_t flow) const
+{
+    const Shard& s = shards[shard_index(key)];
+
+    while (true)
+    {
+        uint32_t before = s.seq.load(std::memory_order_acquire);
+
+        if (before & 1)
+            continue;
+
+        int i = find(s, key);
+        uint64_t owner = i < 0 ? 0 : s.slots[i].word[1].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (s.seq.load(std::memory_order_relaxed) == before)
+            return i < 0 || owner == flow;
+    }
+}
+
+void MqttClientRegistry::connect(uint64_t key, uint64_t flow, const uint32_t* source,
+    uint64_t now_ns, MqttClientConnect& out)
+{
+    Shard& s = shards[shard_index(key)];
+    std::lock_guard<std::mutex> guard(s.lock);
+
+    memset(&out, 0, sizeof(out));
+
+    Entry e;
+    int i = find(s, key);
+
+    if (i >= 0)
+    {
+        load(s.slots[i], e);
+
+        if (e.flow != flow)
+            out.replaced = true;
+
+        if (memcmp(e.source, source, sizeof(e.source)))
+        {
+            out.takeover = out.replaced;
+            e.switches = (now_ns - e.switch_ns <= flap_window_ns) ? e.switches + 1 : 1;
+            e.switch_ns = now_ns;
+        }
+    }
+    else
+    {
+        if (s.count >= shard_limit)
+        {
+            out.full = true;
+            return;
+        }
+
+        i = key & s.mask;
+        while (get_key(s.slots[i]))
+            i = (i + 1) & s.mask;
+
+        memset(&e, 0, sizeof(e));
+        e.key = key;
+        e.switch_ns = now_ns;
+        s.count++;
+    }
+
+    e.flow = flow;
+    memcpy(e.source, source, sizeof(e.source));
+    e.connect_ns = now_ns;
+    out.switches = e.switches;
+
+    write_begin(s);
+    store(s.slots[i], e);
+    write_end(s);
+}
+
+// Backward shift deletion, as in the topic table
+void MqttClientRegistry::release(uint64_t key, uint64_t flow)
+{
+    Shard& s = shards[shard_index(key)];
+    std::lock_guard<std::mutex> guard(s.lock);
+
+    int found = find(s, key);
+
+    if (found < 0 || s.slots[found].word[1].load(std::memory_order_relaxed) != flow)
+        return;
+
+    uint32_t i = found, j = i;
+    Entry e;
+
+    write_begin(s);
+
+    while (true)
+    {
+        j = (j + 1) & s.mask;
+        uint64_t k = get_key(s.slots[j]);
+        if (!k)
+            break;
+
+        uint32_t home = k & s.mask;
+        bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+
+        if (!stays)
+        {
+            load(s.slots[j], e);
+            store(s.slots[i], e);
+            i = j;
+        }
+    }
+
+    memset(&e, 0, sizeof(e));
+    store(s.slots[i], e);
+    s.count--;
+
+    write_end(s);
+}
@@ -0,0 +1,105 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_client_registry.h author Zhinoo Zobairi
+// Client ids in use across all flows, for session takeover detection.
+
+#ifndef MQTT_CLIENT_REGISTRY_H
+#define MQTT_CLIENT_REGISTRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+// Shards are picked by the top bits of the key, slots by the bottom ones
+#define MQTT_REGISTRY_SHARD_BITS 6
+#define MQTT_REGISTRY_SHARDS (1 << MQTT_REGISTRY_SHARD_BITS)
+
+struct MqttClientConnect
+{
+    bool replaced;                  // Another open flow held the client id
+    bool takeover;                  // ... and it came from another source
+    bool full;                      // Shard full, client id not registered
+    uint32_t switches;              // Source changes within the flap window
+};
+
+// Client id hash -> (owning flow, source, connect time), shared by all
+// packet threads. Each shard is an open-addressed table guarded by a mutex
+// for writers and a sequence lock for readers: owns() runs on every client
+// PDU and never blocks, retrying only if a CONNECT or flow end changed the
+// shard meanwhile. Every field is an atomic word so that torn reads are
+// merely discarded, never undefined.
+class MqttClientRegistry
+{
+public:
+    MqttClientRegistry(unsigned capacity, uint32_t flap_window_s);
+
+    // Makes flow the owner of the client id; key is its mqtt_distinct_hash
+    void connect(uint64_t key, uint64_t flow, const uint32_t* source, uint64_t now_ns,
+        MqttClientConnect&);
+
+    // Drops the client id unless another flow has taken it over
+    void release(uint64_t key, uint64_t flow);
+
+    // False once another flow has connected with the client id
+    bool owns(uint64_t key, uint64_t flow) const;
+
+private:
+    struct Entry
+    {
+        uint64_t key;               // 0 = empty
+        uint64_t flow;
+        uint64_t source[2];
+        uint64_t connect_ns;
+        uint64_t switch_ns;         // Last change of source
+        uint64_t switches;
+    };
+
+    struct Slot
+    {
+        std::atomic<uint64_t> word[sizeof(Entry) / sizeof(uint64_t)];
+    };
+
+    struct Shard
+    {
+        std::mutex lock;
+        std::atomic<uint32_t> seq { 0 };    // Odd while a writer is busy
+        std::unique_ptr<Slot[]> slots;
+        uint32_t mask = 0;
+        uint32_t count = 0;
+    };
+
+    Shard shards[MQTT_REGISTRY_SHARDS];
+    uint32_t shard_limit;
+    uint64_t flap_window_ns;
+
+    static unsigned shard_index(uint64_t key)
+    { return key >> (64 - MQTT_REGISTRY_SHARD_BITS); }
+
+    static uint64_t get_key(const Slot& s)
+    { return s.word[0].load(std::memory_order_relaxed); }
+
+    int find(const Shard&, uint64_t key) const;
+    static void load(const Slot&, Entry&);
+    static void store(Slot&, const Entry&);
+    static void write_begin(Shard&);
+    static void write_end(Shard&);
+};
+
+#endif
@@ -0,0 +1,61 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_demand.cc author Zhinoo Zobairi
+// Tracks which parts of a PDU loaded rules and event subscribers consume.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mqtt_demand.h"
+
+#include <atomic>
+
+// Consumers holding each demand bit
+static std::atomic<unsigned> demand_refs[8];
+
+void mqtt_add_demand(uint8_t demand)
+{
+    for (unsigned bit = 0; bit < 8; bit++)
+    {
+        if (demand & (1u << bit))
+            demand_refs[bit]++;
+    }
+}
+
+void mqtt_remove_demand(uint8_t demand)
+{
+    for (unsigned bit = 0; bit < 8; bit++)
+    {
+        if (demand & (1u << bit))
+            demand_refs[bit]--;
+    }
+}
+
+uint8_t mqtt_get_demand()
+{
+    uint8_t demand = 0;
+
+    for (unsigned bit = 0; bit < 8; bit++)
+    {
+        if (demand_refs[bit])
+            demand |= 1u << bit;
+    }
+    return demand;
+}
@@ -0,0 +1,45 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_demand.h author Zhinoo Zobairi
+// Tracks which parts of a PDU loaded rules and event subscribers consume.
+
+#ifndef MQTT_DEMAND_H
+#define MQTT_DEMAND_H
+
+#include <cstdint>
+
+// What the consumers of the inspector need beyond the fixed header and the
+// CONNECT, CONNACK, SUBSCRIBE and acknowledgement fields, which are always
+// parsed because the inspector's own state tracking uses them
+enum mqtt_demand_t : uint8_t
+{
+    MQTT_DEMAND__PUBLISH   = 0x01,  // PUBLISH topic, properties and payload
+    MQTT_DEMAND__SPARKPLUG = 0x02,  // Decoded Sparkplug B metrics
+    MQTT_DEMAND__FEATURES  = 0x04,  // MqttFeatureEvent for every PDU
+    MQTT_DEMAND__ALL       = 0x07
+};
+
+// Rule options and MQTT_FEATURE subscribers add their demand when they are
+// created and remove it when they are destroyed. During a reload the old and
+// new configurations overlap, so the union can only be too wide, never short.
+void mqtt_add_demand(uint8_t demand);
+void mqtt_remove_demand(uint8_t demand);
+uint8_t mqtt_get_demand();
+
+#endif
@@ -32,7 +32,9 @@ struct MqttEventIds
 {
     enum : unsigned
     {
-        MQTT_FEATURE,   // Comprehensive feature event for ML (published for every packet)
+        MQTT_FEATURE,   // Comprehensive feature event for ML (every packet, while mqtt_ml asks or lazy_parse is off)
+        MQTT_SPARKPLUG_METRIC, // One per metric of a Sparkplug B PUBLISH
+        MQTT_KEEPALIVE_EXPIRY, // A client went silent, published as its deadline passes
         MAX
     };
 };
@@ -77,8 +79,15 @@ public:
     uint16_t msg_id = 0;            // Packet identifier (for QoS > 0)
     
     // Timing features (microseconds)
-    int64_t time_delta_us = 0;      // Time since first packet in flow
-    int64_t time_relative_us = 0;   // Same as delta (for compatibility)
+    int64_t time_delta_us = 0;      // Time since the previous packet in flow
+    int64_t time_relative_us = 0;   // Time since first packet in flow
+
+    // Rate and inter-arrival statistics (not yet part of the model input)
+    float iat_mean_us = 0.0f;       // EWMA of the inter-arrival time
+    float iat_stddev_us = 0.0f;     // EWMA standard deviation of the inter-arrival time
+    float publish_rate = 0.0f;      // PUBLISH per second, exponentially decayed
+    float byte_rate = 0.0f;         // PDU bytes per second, exponentially decayed
+    float burstiness = 0.0f;        // (sigma - mu) / (sigma + mu) of the inter-arrival time
     
     // Brute force detection
     float failed_auth_per_second = 0.0f;
@@ -86,6 +95,98 @@ public:
     
     // Flow statistics
     uint32_t pkt_count = 0;         // Packet count in this flow
+
+    // Protocol state machine (not yet part of the model input)
+    uint8_t conn_state = 0;         // mqtt_conn_state_t after this packet
+    uint8_t state_violation = 0;    // mqtt_sm_violation_t raised by this packet, 0 = none
+    uint32_t conformance = 0;       // mqtt_conformance_t bits found while parsing
+
+    // QoS 2 handshake tracking (not yet part of the model input)
+    uint32_t qos2_inflight = 0;     // Open PUBLISH→PUBCOMP handshakes
+    uint32_t qos2_stalled = 0;      // Open handshakes older than the stall timeout
+    int64_t qos2_oldest_age_us = 0; // Time since the oldest open handshake last progressed
+    uint32_t qos2_dup_ids = 0;      // PUBLISH reusing an in-flight identifier without DUP
+
+    // SUBSCRIBE/UNSUBSCRIBE filters (not yet part of the model input)
+    uint16_t filter_count = 0;      // Topic filters in the request
+    uint16_t wildcard_count = 0;    // Filters using '+' or '#'
+    uint16_t multilevel_count = 0;  // Filters using '#'
+
+    // MQTT 5.0 properties (not yet part of the model input)
+    uint8_t reason_code = 0;        // Reason code of acks, DISCONNECT and AUTH
+    uint16_t properties_len = 0;    // Property block length
+    uint8_t property_count = 0;     // Distinct properties in the block
+    uint16_t user_prop_count = 0;
+    uint32_t user_prop_bytes = 0;   // Name and value bytes of all user properties
+    uint16_t topic_alias = 0;
+    uint32_t session_expiry = 0;    // Seconds, CONNECT, CONNACK and DISCONNECT
+    uint32_t message_expiry = 0;    // Seconds, PUBLISH
+    uint16_t receive_maximum = 0;
+    uint16_t content_type_len = 0;
+
+    // Keep-alive enforcement (not yet part of the model input)
+    uint64_t idle_us = 0;           // Client silence before its last packet
+    uint8_t keepalive_expired = 0;  // Client went silent past the keep-alive limit
+    uint32_t keepalive_overruns = 0; // Consecutive late-but-allowed client gaps
+
+    // Sparkplug B (not yet part of the model input)
+    uint16_t sparkplug_metrics = 0; // Metrics in a Sparkplug B payload
+
+    // Topic table (not yet part of the model input)
+    uint32_t topic_id = 0;          // Per-thread PUBLISH topic id, 0 = not interned
+    float size_zscore = 0.0f;       // Payload size against the topic baseline
+    float interval_zscore = 0.0f;   // Publish interval against the topic baseline
+
+    // Payload content (not yet part of the model input), over at most
+    // payload_profile_len bytes
+    float payload_entropy = 0.0f;   // Shannon entropy, bits per byte
+    float payload_printable = 0.0f; // Share of whitespace and printable ASCII
+    uint16_t payload_classes[7] = { }; // Bytes per mqtt_byte_class_t
+
+    // Source credential churn (not yet part of the model input), CONNECT only
+    uint32_t distinct_usernames = 0;
+    uint32_t distinct_passwords = 0;
+    uint32_t distinct_client_ids = 0;
+
+    // Client id registry (not yet part of the model input)
+    uint8_t client_id_replaced = 0; // Accepted CONNECT reused the id of another open flow
+    uint8_t client_id_takeover = 0; // ... from another source
+    uint8_t client_id_refused_reuse = 0; // Refused CONNECT named the id of another open flow
+    uint16_t client_id_switches = 0; // Source changes of the id within the flap window
+    uint8_t session_superseded = 0; // Client PDU on a flow whose id was taken since
+
+    // Set by subscribers during the publish
+    uint8_t anomalous = 0;          // A detector found the PDU anomalous
+};
+
+// MqttSparkplugMetricEvent describes one metric of a Sparkplug B payload.
+// The pointers refer to the packet and are only valid during the publish.
+class MqttSparkplugMetricEvent : public snort::DataEvent
+{
+public:
+    const uint8_t* name = nullptr;  // Null when the metric only has an alias
+    uint32_t name_len = 0;
+    uint64_t alias = 0;
+    uint32_t datatype = 0;          // Sparkplug DataType
+    uint8_t value_type = 0;         // mqtt_sparkplug_value_t
+    uint8_t is_null = 0;
+    int64_t int_value = 0;          // Signed per datatype, doubles truncated
+    double double_value = 0.0;
+    const uint8_t* str = nullptr;   // String and bytes values
+    uint32_t str_len = 0;
+    uint64_t seq = 0;               // Payload sequence number
+    uint16_t index = 0;             // Position of the metric in the payload
+};
+
+// MqttKeepaliveExpiredEvent goes out when the keep-alive deadline of a
+// silent client passes. It is published while another flow's packet is
+// being inspected, so consumers must not queue events on that packet; the
+// silent flow is the one passed with the event.
+class MqttKeepaliveExpiredEvent : public snort::DataEvent
+{
+public:
+    uint64_t idle_us = 0;           // Client silence so far
+    uint16_t keep_alive = 0;        // Seconds, from CONNECT
 };
 
 } // namespace snort
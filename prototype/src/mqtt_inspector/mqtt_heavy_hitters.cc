@@ -0,0 +1,392 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_heavy_hitters.cc author Zhinoo Zobairi
+// Space-Saving summaries of the busiest sources, client ids and topics.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mqtt_heavy_hitters.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+
+#include "log/messages.h"
+#include "main/thread.h"
+#include "sfip/sf_ip.h"
+
+using namespace snort;
+
+// Keys listed per summary by the dump command
+#define MQTT_HH_DUMP_MAX 10
+
+THREAD_LOCAL MqttHeavyHitters* mqtt_heavy_hitters = nullptr;
+
+static const char* const key_names[MQTT_HH_KEY__MAX] = { "source", "client id", "topic" };
+static const char* const weight_names[MQTT_HH_WEIGHT__MAX] = { "messages", "bytes" };
+
+static uint64_t key_hash(const uint8_t* key, unsigned len)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned i = 0; i < len; i++)
+    {
+        h ^= key[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// Sources are kept as the 16 address bytes of the SfIp and an IPv4 flag,
+// names with anything unprintable masked and "..." when they were cut
+static std::string format_key(unsigned kt, const uint8_t* key, unsigned kept, unsigned len)
+{
+    if (kt == MQTT_HH_KEY__SOURCE)
+    {
+        SfIp ip;
+        char buf[INET6_ADDRSTRLEN];
+
+        if (len != MQTT_HH_SOURCE_LEN || kept != len)
+            return "?";
+
+        if (key[16])
+            ip.set(key + 12, AF_INET);
+        else
+            ip.set(key, AF_INET6);
+
+        return ip.ntop(buf, sizeof(buf));
+    }
+
+    std::string s((const char*)key, kept);
+    for (char& c : s)
+    {
+        if (c < 0x20 || c == 0x7F)
+            c = '.';
+    }
+    if (len > kept)
+        s += "...";
+    return s;
+}
+
+//-------------------------------------------------------------------------
+// Space-Saving
+//-------------------------------------------------------------------------
+
+MqttSpaceSaving::MqttSpaceSaving(unsigned k) :
+    items(k), heap(k), heap_pos(k)
+{
+    uint32_t size = 2;
+    while (size < 2 * k)
+        size <<= 1;
+
+    slots.assign(size, 0);
+    slot_mask = size - 1;
+}
+
+void MqttSpaceSaving::clear()
+{
+    std::fill(slots.begin(), slots.end(), 0);
+    count = 0;
+}
+
+uint32_t MqttSpaceSaving::find_slot(uint32_t item) const
+{
+    uint32_t i = items[item].hash & slot_mask;
+
+    while (slots[i] != item + 1)
+        i = (i + 1) & slot_mask;
+
+    return i;
+}
+
+void MqttSpaceSaving::insert_slot(uint32_t item)
+{
+    uint32_t i = items[item].hash & slot_mask;
+
+    while (slots[i])
+        i = (i + 1) & slot_mask;
+
+    slots[i] = item + 1;
+}
+
+// Backward shift deletion, as in the topic table
+void MqttSpaceSaving::remove_slot(uint32_t item)
+{
+    uint32_t i = find_slot(item);
+    uint32_t j = i;
+
+    while (true)
+    {
+        j = (j + 1) & slot_mask;
+        if (!slots[j])
+            break;
+
+        uint32_t home = items[slots[j] - 1].hash & slot_mask;
+        bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+
+        if (!stays)
+        {
+            slots[i] = slots[j];
+            i = j;
+        }
+    }
+    slots[i] = 0;
+}
+
+void MqttSpaceSaving::swap_heap(unsigned a, unsigned b)
+{
+    std::swap(heap[a], heap[b]);
+    heap_pos[heap[a]] = a;
+    heap_pos[heap[b]] = b;
+}
+
+void MqttSpaceSaving::sift_up(unsigned pos)
+{
+    while (pos)
+    {
+        unsigned parent = (pos - 1) / 2;
+        if (items[heap[parent]].count <= items[heap[pos]].count)
+            break;
+
+        swap_heap(pos, parent);
+        pos = parent;
+    }
+}
+
+void MqttSpaceSaving::sift_down(unsigned pos)
+{
+    while (true)
+    {
+        unsigned least = pos;
+        unsigned l = 2 * pos + 1, r = l + 1;
+
+        if (l < count && items[heap[l]].count < items[heap[least]].count)
+            least = l;
+        if (r < count && items[heap[r]].count < items[heap[least]].count)
+            least = r;
+
+        if (least == pos)
+            break;
+
+        swap_heap(pos, least);
+        pos = least;
+    }
+}
+
+void MqttSpaceSaving::add(const uint8_t* key, unsigned len, uint64_t weight)
+{
+    if (items.empty())
+        return;
+
+    uint64_t h = key_hash(key, len);
+    uint32_t i = h & slot_mask;
+    unsigned kept = len < MQTT_HH_KEY_MAX ? len : MQTT_HH_KEY_MAX;
+
+    while (uint32_t s = slots[i])
+    {
+        MqttHeavyHitter& hh = items[s - 1];
+        if (hh.hash == h && hh.len == len && !memcmp(hh.key, key, kept))
+        {
+            hh.count += weight;
+            sift_down(heap_pos[s - 1]);
+            return;
+        }
+        i = (i + 1) & slot_mask;
+    }
+
+    uint32_t item;
+    uint64_t floor = 0;
+
+    if (count < items.size())
+    {
+        item = count;
+        heap[count] = item;
+        heap_pos[item] = count;
+        count++;
+    }
+    else
+    {
+        item = heap[0];
+        floor = items[item].count;
+        remove_slot(item);
+    }
+
+    MqttHeavyHitter& hh = items[item];
+    hh.count = floor + weight;
+    hh.error = floor;
+    hh.hash = h;
+    hh.len = len;
+    hh.kept = kept;
+    memcpy(hh.key, key, kept);
+    insert_slot(item);
+
+    // A new counter starts at the bottom, a reused one at the top
+    if (floor)
+        sift_down(heap_pos[item]);
+    else
+        sift_up(heap_pos[item]);
+}
+
+//-------------------------------------------------------------------------
+// per-thread summaries
+//-------------------------------------------------------------------------
+
+MqttHeavyHitters::MqttHeavyHitters(unsigned k)
+{
+    for (auto& s : sketch)
+        s.assign(MQTT_HH_WEIGHT__MAX, MqttSpaceSaving(k));
+}
+
+void MqttHeavyHitters::tick(uint64_t now_ns, uint64_t interval_ns)
+{
+    if (!interval_start_ns)
+    {
+        interval_start_ns = now_ns;
+        return;
+    }
+
+    if (now_ns - interval_start_ns < interval_ns)
+        return;
+
+    std::string line;
+
+    for (unsigned kt = 0; kt < MQTT_HH_KEY__MAX; kt++)
+    {
+        const MqttSpaceSaving& s = sketch[kt][MQTT_HH_WEIGHT__MSGS];
+        const MqttHeavyHitter* top = nullptr;
+
+        for (unsigned i = 0; i < s.size(); i++)
+        {
+            if (!top || s.get(i).count > top->count)
+                top = &s.get(i);
+        }
+
+        if (!top)
+            continue;
+
+        char count[32];
+        snprintf(count, sizeof(count), " (%" PRIu64 ")", top->count);
+        line += line.empty() ? " " : ", ";
+        line += key_names[kt];
+        line += " ";
+        line += format_key(kt, top->key, top->kept, top->len);
+        line += count;
+    }
+
+    if (!line.empty())
+        LogMessage("mqtt heavy hitters, thread %u, last %" PRIu64 " s:%s\n", get_instance_id(),
+            (now_ns - interval_start_ns) / 1000000000ULL, line.c_str());
+
+    for (auto& s : sketch)
+    {
+        for (auto& w : s)
+            w.clear();
+    }
+    interval_start_ns = now_ns;
+}
+
+//-------------------------------------------------------------------------
+// dump command
+//-------------------------------------------------------------------------
+
+// A merged count is at least the sum of count - error over the threads
+// listing the key, and at most the sum of their counts plus the floor of
+// every other thread, since those may have counted the key up to it
+bool MqttHeavyHitterCommand::execute(Analyzer&, void**)
+{
+    const MqttHeavyHitters* hh = mqtt_heavy_hitters;
+
+    if (!hh)
+        return true;
+
+    std::lock_guard<std::mutex> guard(lock);
+    threads++;
+
+    for (unsigned kt = 0; kt < MQTT_HH_KEY__MAX; kt++)
+    {
+        for (unsigned wt = 0; wt < MQTT_HH_WEIGHT__MAX; wt++)
+        {
+            const MqttSpaceSaving& s = hh->get(kt, wt);
+            Summary& sum = merged[kt][wt];
+            uint64_t floor = s.get_floor();
+
+            sum.floors += floor;
+
+            for (unsigned i = 0; i < s.size(); i++)
+            {
+                const MqttHeavyHitter& e = s.get(i);
+                std::string key((const char*)e.key, e.kept);
+                key.append((const char*)&e.len, sizeof(e.len));
+                key.append((const char*)&e.hash, sizeof(e.hash));
+
+                Merged& m = sum.keys[key];
+                if (m.shown.empty())
+                {
+                    m.shown.assign((const char*)e.key, e.kept);
+                    m.len = e.len;
+                }
+                m.count += e.count;
+                m.error += e.error;
+                m.floors += floor;
+            }
+        }
+    }
+    return true;
+}
+
+MqttHeavyHitterCommand::~MqttHeavyHitterCommand()
+{
+    if (!threads)
+    {
+        LogMessage("mqtt heavy hitters: not enabled\n");
+        return;
+    }
+
+    LogMessage("mqtt heavy hitters, %u threads:\n", threads);
+
+    for (unsigned kt = 0; kt < MQTT_HH_KEY__MAX; kt++)
+    {
+        for (unsigned wt = 0; wt < MQTT_HH_WEIGHT__MAX; wt++)
+        {
+            const Summary& sum = merged[kt][wt];
+            std::vector<std::pair<const std::string*, const Merged*>> top;
+
+            for (const auto& k : sum.keys)
+                top.emplace_back(&k.first, &k.second);
+
+            size_t shown = std::min<size_t>(top.size(), MQTT_HH_DUMP_MAX);
+            std::partial_sort(top.begin(), top.begin() + shown, top.end(),
+                [](const std::pair<const std::string*, const Merged*>& a,
+                    const std::pair<const std::string*, const Merged*>& b)
+                { return a.second->count > b.second->count; });
+
+            LogMessage("  %s by %s:\n", key_names[kt], weight_names[wt]);
+
+            for (size_t i = 0; i < shown; i++)
+            {
+                const Merged& m = *top[i].second;
+
+                LogMessage("    %s: %" PRIu64 " (%" PRIu64 " to %" PRIu64 ")\n",
+                    format_key(kt, (const uint8_t*)m.shown.data(), m.shown.size(), m.len).c_str(),
+                    m.count, m.count - m.error, m.count + sum.floors - m.floors);
+            }
+        }
+    }
+}
@@ -0,0 +1,163 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_heavy_hitters.h author Zhinoo Zobairi
+// Space-Saving summaries of the busiest sources, client ids and topics.
+
+#ifndef MQTT_HEAVY_HITTERS_H
+#define MQTT_HEAVY_HITTERS_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "main/analyzer_command.h"
+
+// Longer client ids and topics are told apart by length and a hash of the
+// whole key; only this many bytes are kept to show
+#define MQTT_HH_KEY_MAX 64
+
+// Source keys are the IPv6 (or mapped IPv4) address and an IPv4 flag
+#define MQTT_HH_SOURCE_LEN 17
+
+enum mqtt_hh_key_t : uint8_t
+{
+    MQTT_HH_KEY__SOURCE,            // Client address of the flow, see MQTT_HH_SOURCE_LEN
+    MQTT_HH_KEY__CLIENT_ID,         // Client id of the CONNECT
+    MQTT_HH_KEY__TOPIC,             // PUBLISH topic
+    MQTT_HH_KEY__MAX
+};
+
+enum mqtt_hh_weight_t : uint8_t
+{
+    MQTT_HH_WEIGHT__MSGS,
+    MQTT_HH_WEIGHT__BYTES,
+    MQTT_HH_WEIGHT__MAX
+};
+
+struct MqttHeavyHitter
+{
+    uint64_t count;                 // Never below the true count
+    uint64_t error;                 // count - error is never above it
+    uint64_t hash;                  // Of the whole key
+    uint32_t len;                   // Of the whole key
+    uint8_t kept;                   // Leading bytes in key
+    uint8_t key[MQTT_HH_KEY_MAX];
+};
+
+// Weighted Space-Saving (Metwally et al.) over k counters. A key that is
+// not tracked takes over the smallest counter and inherits its count as
+// error, so every key heavier than total / k is guaranteed to be listed.
+// The counters form a min-heap found through an open-addressed index;
+// an update costs one probe and a sift that rarely moves.
+class MqttSpaceSaving
+{
+public:
+    MqttSpaceSaving(unsigned k);
+
+    void add(const uint8_t* key, unsigned len, uint64_t weight);
+    void clear();
+
+    unsigned size() const
+    { return count; }
+
+    const MqttHeavyHitter& get(unsigned i) const
+    { return items[i]; }
+
+    // Count a key not listed may have, 0 until every counter is used
+    uint64_t get_floor() const
+    { return count == items.size() ? items[heap[0]].count : 0; }
+
+private:
+    std::vector<MqttHeavyHitter> items;
+    std::vector<uint32_t> heap;     // Item indexes, smallest count first
+    std::vector<uint32_t> heap_pos; // Heap index of each item
+    std::vector<uint32_t> slots;    // Item index + 1, 0 = empty
+    uint32_t slot_mask = 0;
+    unsigned count = 0;
+
+    uint32_t find_slot(uint32_t item) const;
+    void remove_slot(uint32_t item);
+    void insert_slot(uint32_t item);
+    void swap_heap(unsigned a, unsigned b);
+    void sift_up(unsigned pos);
+    void sift_down(unsigned pos);
+};
+
+// The summaries of one packet thread
+class MqttHeavyHitters
+{
+public:
+    MqttHeavyHitters(unsigned k);
+
+    void add(mqtt_hh_key_t kt, const uint8_t* key, unsigned len, uint64_t bytes)
+    {
+        sketch[kt][MQTT_HH_WEIGHT__MSGS].add(key, len, 1);
+        sketch[kt][MQTT_HH_WEIGHT__BYTES].add(key, len, bytes);
+    }
+
+    // Logs the top key of each kind and starts a new interval once
+    // interval_ns have passed since the last one
+    void tick(uint64_t now_ns, uint64_t interval_ns);
+
+    const MqttSpaceSaving& get(unsigned kt, unsigned wt) const
+    { return sketch[kt][wt]; }
+
+private:
+    std::vector<MqttSpaceSaving> sketch[MQTT_HH_KEY__MAX];
+    uint64_t interval_start_ns = 0;
+};
+
+// Merges the summaries of every packet thread and logs the result once
+// the last thread is done
+class MqttHeavyHitterCommand : public snort::AnalyzerCommand
+{
+public:
+    ~MqttHeavyHitterCommand() override;
+
+    bool execute(snort::Analyzer&, void**) override;
+
+    const char* stringify() override
+    { return "MQTT_HEAVY_HITTERS"; }
+
+private:
+    struct Merged
+    {
+        uint64_t count = 0;
+        uint64_t error = 0;
+        uint64_t floors = 0;        // Sum of the floors of the threads listing the key
+        std::string shown;          // Leading bytes of the key
+        uint32_t len = 0;           // Of the whole key
+    };
+
+    struct Summary
+    {
+        std::unordered_map<std::string, Merged> keys;  // By leading bytes, length and hash
+        uint64_t floors = 0;        // Sum of the floors of all threads
+    };
+
+    std::mutex lock;
+    Summary merged[MQTT_HH_KEY__MAX][MQTT_HH_WEIGHT__MAX];
+    unsigned threads = 0;
+};
+
+extern THREAD_LOCAL MqttHeavyHitters* mqtt_heavy_hitters;
+
+#endif
@@ -0,0 +1,114 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_inflate.cc author Zhinoo Zobairi
+// Bounded inflation of zlib and gzip PUBLISH payloads.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mqtt_inflate.h"
+
+#include <cstring>
+
+#include "mqtt.h"
+
+MqttInflater::MqttInflater(uint32_t out, uint32_t ratio) :
+    max_out(out), max_ratio(ratio)
+{
+    scratch = new uint8_t[max_out];
+
+    memset(&zs, 0, sizeof(zs));
+    // 15 + 32: full window, detect the zlib or gzip header
+    zs_ready = (inflateInit2(&zs, 15 + 32) == Z_OK);
+}
+
+MqttInflater::~MqttInflater()
+{
+    if (zs_ready)
+        inflateEnd(&zs);
+    delete[] scratch;
+}
+
+bool MqttInflater::is_compressed(const uint8_t* data, unsigned len)
+{
+    if (len < 2)
+        return false;
+
+    // gzip (RFC 1952) with deflate
+    if (data[0] == 0x1f && data[1] == 0x8b)
+        return len >= 3 && data[2] == 8;
+
+    // zlib (RFC 1950): deflate, window up to 32K, check bits
+    return (data[0] & 0x0f) == 8 && (data[0] >> 4) <= 7 &&
+        ((data[0] << 8) | data[1]) % 31 == 0;
+}
+
+bool MqttInflater::inflate(uint64_t packet_number, const uint8_t* data, unsigned len,
+    const uint8_t*& out, unsigned& out_len)
+{
+    if (packet_number != last_packet || data != last_data)
+    {
+        last_packet = packet_number;
+        last_data = data;
+        last_len = 0;
+        last_ok = false;
+
+        if (!zs_ready || !is_compressed(data, len))
+            return false;
+
+        uint64_t ratio_limit = (uint64_t)len * max_ratio;
+        uint32_t limit = ratio_limit < max_out ? ratio_limit : max_out;
+
+        inflateReset(&zs);
+        zs.next_in = const_cast<Bytef*>(data);
+        zs.avail_in = len;
+        zs.next_out = scratch;
+        zs.avail_out = limit;
+
+        int ret = ::inflate(&zs, Z_SYNC_FLUSH);
+        last_len = limit - zs.avail_out;
+
+        if (ret != Z_STREAM_END)
+        {
+            // Output full with input left is a limit, anything else an error
+            if ((ret == Z_OK || ret == Z_BUF_ERROR) && zs.avail_out == 0)
+            {
+                if (limit == max_out)
+                    mqtt_stats.decompress_cap_hits++;
+                else
+                    mqtt_stats.decompress_ratio_hits++;
+            }
+            else
+                mqtt_stats.decompress_errors++;
+        }
+
+        // Whatever came out before a limit or an error is still inspected
+        last_ok = last_len > 0;
+        if (last_ok)
+        {
+            mqtt_stats.decompressed_payloads++;
+            mqtt_stats.decompressed_bytes += last_len;
+        }
+    }
+
+    out = scratch;
+    out_len = last_len;
+    return last_ok;
+}
@@ -0,0 +1,61 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_inflate.h author Zhinoo Zobairi
+// Bounded inflation of zlib and gzip PUBLISH payloads.
+
+#ifndef MQTT_INFLATE_H
+#define MQTT_INFLATE_H
+
+#include <cstdint>
+
+#include <zlib.h>
+
+// One per packet thread. The zlib stream and the output buffer are set up
+// once and reused for every payload. Output stops at max_out bytes and at
+// max_ratio times the compressed size, whichever comes first, so a small
+// decompression bomb costs no more than max_out bytes of work.
+class MqttInflater
+{
+public:
+    MqttInflater(uint32_t max_out, uint32_t max_ratio);
+    ~MqttInflater();
+
+    // gzip magic or a valid zlib header
+    static bool is_compressed(const uint8_t* data, unsigned len);
+
+    // Inflates data unless it is the payload of the PDU inflated last;
+    // false when nothing could be inflated. Pegs are counted here.
+    bool inflate(uint64_t packet_number, const uint8_t* data, unsigned len,
+        const uint8_t*& out, unsigned& out_len);
+
+private:
+    z_stream zs;
+    uint8_t* scratch;
+    uint32_t max_out;
+    uint32_t max_ratio;
+    bool zs_ready;
+
+    // Result for the last PDU
+    uint64_t last_packet = 0;
+    const uint8_t* last_data = nullptr;
+    unsigned last_len = 0;
+    bool last_ok = false;
+};
+
+#endif
@@ -0,0 +1,383 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_json.cc author Zhinoo Zobairi
+// Single pass locating many JSON key paths in an MQTT payload.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mqtt_json.h"
+
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define ROOT 0
+#define NO_NODE UINT32_MAX
+#define NO_ID UINT32_MAX
+
+//-------------------------------------------------------------------------
+// tokenizer helpers
+//-------------------------------------------------------------------------
+
+static inline bool is_ws(uint8_t c)
+{ return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+static inline unsigned skip_ws(const uint8_t* data, unsigned len, unsigned pos)
+{
+    while (pos < len && is_ws(data[pos]))
+        pos++;
+    return pos;
+}
+
+// Position of the closing quote of a string whose contents start at pos,
+// len when it is not closed. Most of a payload is string contents, so
+// 16 bytes at a time are checked for a quote or a backslash.
+static unsigned scan_string(const uint8_t* data, unsigned len, unsigned pos)
+{
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+
+    while (pos + 16 <= len)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        unsigned mask = _mm_movemask_epi8(_mm_or_si128(
+            _mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+
+        if (!mask)
+        {
+            pos += 16;
+            continue;
+        }
+
+        pos += __builtin_ctz(mask);
+        if (data[pos] == '"')
+            return pos;
+        pos += 2;                   // Escaped character
+    }
+#endif
+
+    while (pos < len)
+    {
+        if (data[pos] == '"')
+            return pos;
+        pos += (data[pos] == '\\') ? 2 : 1;
+    }
+    return len;
+}
+
+// End of a number, true, false or null
+static unsigned scan_scalar(const uint8_t* data, unsigned len, unsigned pos)
+{
+    while (pos < len)
+    {
+        uint8_t c = data[pos];
+        if (c == ',' || c == '}' || c == ']' || is_ws(c))
+            break;
+        pos++;
+    }
+    return pos;
+}
+
+//-------------------------------------------------------------------------
+// paths
+//-------------------------------------------------------------------------
+
+MqttJsonPaths::MqttJsonPaths()
+{
+    new_node();
+}
+
+uint32_t MqttJsonPaths::new_node()
+{
+    nodes.push_back({ NO_ID, 0, 0, 0, 0 });
+    build_children.emplace_back();
+    return nodes.size() - 1;
+}
+
+bool MqttJsonPaths::valid_path(const char* path, unsigned len)
+{
+    if (len == 0 || path[0] != '$')
+        return false;
+
+    unsigned pos = 1;
+
+    while (pos < len)
+    {
+        if (path[pos] == '.')
+        {
+            unsigned start = ++pos;
+            while (pos < len && path[pos] != '.' && path[pos] != '[')
+                pos++;
+            if (pos == start)
+                return false;
+        }
+        else if (path[pos] == '[')
+        {
+            unsigned start = ++pos;
+            while (pos < len && path[pos] >= '0' && path[pos] <= '9')
+                pos++;
+            if (pos == start || pos - start > 9 || pos == len || path[pos] != ']')
+                return false;
+            pos++;
+        }
+        else
+            return false;
+    }
+    return true;
+}
+
+unsigned MqttJsonPaths::add(const char* path, unsigned len)
+{
+    auto known = build_paths.find(std::string(path, len));
+    if (known != build_paths.end())
+        return known->second;
+
+    unsigned id = path_count++;
+    build_paths.emplace(std::string(path, len), id);
+
+    uint32_t node = ROOT;
+    unsigned pos = 1;
+
+    while (pos < len)
+    {
+        // Labels keep their '.' or '[' so keys and indexes never collide
+        unsigned start = pos++;
+        while (pos < len && path[pos] != '.' && path[pos] != '[')
+            pos++;
+
+        std::string label(path + start, pos - start);
+        if (label[0] == '[')
+            label.pop_back();
+
+        auto it = build_children[node].find(label);
+        if (it == build_children[node].end())
+        {
+            uint32_t n = new_node();
+            it = build_children[node].emplace(label, n).first;
+        }
+        node = it->second;
+    }
+
+    nodes[node].id = id;
+    return id;
+}
+
+void MqttJsonPaths::compile()
+{
+    for (uint32_t n = 0; n < nodes.size(); n++)
+    {
+        nodes[n].keys = edges.size();
+        for (const auto& c : build_children[n])
+        {
+            if (c.first[0] == '.')
+            {
+                edges.push_back({ (uint32_t)labels.size(), (uint32_t)c.first.size() - 1, c.second });
+                labels.append(c.first, 1, std::string::npos);
+            }
+        }
+        nodes[n].key_count = edges.size() - nodes[n].keys;
+
+        nodes[n].indexes = edges.size();
+        for (const auto& c : build_children[n])
+        {
+            if (c.first[0] == '[')
+                edges.push_back({ (uint32_t)std::stoul(c.first.substr(1)), 0, c.second });
+        }
+        nodes[n].index_count = edges.size() - nodes[n].indexes;
+    }
+
+    build_children.clear();
+    build_paths.clear();
+    compiled = true;
+}
+
+// Rules ask for a handful of keys per object, a linear look is enough
+uint32_t MqttJsonPaths::key_child(uint32_t node, const uint8_t* key, unsigned len) const
+{
+    if (node == NO_NODE)
+        return NO_NODE;
+
+    const Node& n = nodes[node];
+    for (uint32_t i = n.keys; i < n.keys + n.key_count; i++)
+    {
+        if (edges[i].label_len == len && !memcmp(labels.data() + edges[i].label, key, len))
+            return edges[i].child;
+    }
+    return NO_NODE;
+}
+
+uint32_t MqttJsonPaths::index_child(uint32_t node, uint32_t index) const
+{
+    if (node == NO_NODE)
+        return NO_NODE;
+
+    const Node& n = nodes[node];
+    for (uint32_t i = n.indexes; i < n.indexes + n.index_count; i++)
+    {
+        if (edges[i].label == index)
+            return edges[i].child;
+    }
+    return NO_NODE;
+}
+
+//-------------------------------------------------------------------------
+// scan
+//-------------------------------------------------------------------------
+
+bool MqttJsonPaths::scan(const uint8_t* data, unsigned len, MqttJsonSpan* spans) const
+{
+    for (unsigned i = 0; i < path_count; i++)
+        spans[i].found = false;
+
+    if (!compiled || !path_count)
+        return true;
+
+    struct Level
+    {
+        uint32_t node;              // Trie node of the container, NO_NODE = no path below
+        uint32_t index;             // Current array element
+        uint32_t start;
+        bool object;
+    };
+
+    Level stack[MQTT_JSON_MAX_DEPTH];
+    unsigned depth = 0;
+    unsigned remaining = path_count;
+
+    // Records the value of node; true when every path has been found
+    auto report = [&](uint32_t node, uint32_t start, uint32_t end)
+    {
+        if (node == NO_NODE || nodes[node].id == NO_ID || spans[nodes[node].id].found)
+            return false;
+
+        spans[nodes[node].id] = { start, end - start, true };
+        return --remaining == 0;
+    };
+
+    // Reads "key": and moves node to the key's child of parent
+    auto read_key = [&](unsigned& pos, uint32_t parent, uint32_t& node)
+    {
+        if (pos >= len || data[pos] != '"')
+            return false;
+
+        unsigned end = scan_string(data, len, pos + 1);
+        if (end >= len)
+            return false;
+
+        node = key_child(parent, data + pos + 1, end - pos - 1);
+        pos = skip_ws(data, len, end + 1);
+
+        if (pos >= len || data[pos] != ':')
+            return false;
+
+        pos = skip_ws(data, len, pos + 1);
+        return true;
+    };
+
+    uint32_t node = ROOT;
+    unsigned pos = skip_ws(data, len, 0);
+
+    while (true)
+    {
+        // A value starts at pos
+        if (pos >= len)
+            return false;
+
+        uint8_t c = data[pos];
+
+        if (c == '{' || c == '[')
+        {
+            if (depth == MQTT_JSON_MAX_DEPTH)
+                return false;
+
+            bool object = (c == '{');
+            stack[depth++] = { node, 0, pos, object };
+            pos = skip_ws(data, len, pos + 1);
+
+            if (pos >= len)
+                return false;
+
+            // An empty container is closed below like any other
+            if (data[pos] != (object ? '}' : ']'))
+            {
+                if (object && !read_key(pos, stack[depth - 1].node, node))
+                    return false;
+                if (!object)
+                    node = index_child(stack[depth - 1].node, 0);
+                continue;
+            }
+        }
+        else if (c == '"')
+        {
+            unsigned end = scan_string(data, len, pos + 1);
+            if (end >= len)
+                return false;
+
+            if (report(node, pos + 1, end))
+                return true;
+            pos = end + 1;
+        }
+        else
+        {
+            unsigned end = scan_scalar(data, len, pos);
+            if (end == pos)
+                return false;
+
+            if (report(node, pos, end))
+                return true;
+            pos = end;
+        }
+
+        // Close finished containers until the next member or element
+        while (true)
+        {
+            pos = skip_ws(data, len, pos);
+            if (depth == 0)
+                return true;
+            if (pos >= len)
+                return false;
+
+            Level& top = stack[depth - 1];
+            c = data[pos];
+
+            if (c == ',')
+            {
+                pos = skip_ws(data, len, pos + 1);
+                if (top.object && !read_key(pos, top.node, node))
+                    return false;
+                if (!top.object)
+                    node = index_child(top.node, ++top.index);
+                break;
+            }
+
+            if (c != (top.object ? '}' : ']'))
+                return false;
+
+            pos++;
+            depth--;
+            if (report(top.node, top.start, pos))
+                return true;
+        }
+    }
+}
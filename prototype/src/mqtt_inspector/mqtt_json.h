@@ -0,0 +1,106 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_json.h author Zhinoo Zobairi
+// Single pass locating many JSON key paths in an MQTT payload.
+
+#ifndef MQTT_JSON_H
+#define MQTT_JSON_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Containers nested deeper than this end the scan
+#define MQTT_JSON_MAX_DEPTH 32
+
+// Where the value of one path was found, valid when found is set. String
+// values span their contents without the quotes, objects and arrays span
+// their brackets, other values their literal.
+struct MqttJsonSpan
+{
+    uint32_t offset;
+    uint32_t len;
+    bool found;
+};
+
+// Paths are added while the rules are read, then compile() freezes them.
+// A path is "$" followed by ".key" and "[index]" steps, e.g. $.fw.url or
+// $.readings[0].value. Keys are compared with the raw bytes between the
+// quotes, escapes are not decoded. The first occurrence of a path wins.
+//
+// scan() tokenizes the payload once with a fixed-size stack and reports
+// every path at the same time, without allocating. It stops early when
+// all paths were found, or at the first syntax error (keeping what was
+// found before it).
+class MqttJsonPaths
+{
+public:
+    MqttJsonPaths();
+
+    static bool valid_path(const char* path, unsigned len);
+
+    // Returns the path's id; adding an identical path returns the same id
+    unsigned add(const char* path, unsigned len);
+
+    void compile();
+
+    bool is_compiled() const
+    { return compiled; }
+
+    unsigned size() const
+    { return path_count; }
+
+    // spans must hold size() entries; returns false for malformed JSON
+    bool scan(const uint8_t* data, unsigned len, MqttJsonSpan* spans) const;
+
+private:
+    struct Node
+    {
+        uint32_t id;                // Path ending here, NO_ID = none
+        uint32_t keys;              // First index into edges
+        uint32_t key_count;
+        uint32_t indexes;           // Array element children, first index into edges
+        uint32_t index_count;
+    };
+
+    struct Edge
+    {
+        uint32_t label;             // Offset into labels, or the array index
+        uint32_t label_len;
+        uint32_t child;
+    };
+
+    // Build state, dropped by compile(); '[' starts index labels
+    std::vector<std::map<std::string, uint32_t>> build_children;
+    std::map<std::string, unsigned> build_paths;
+
+    std::vector<Node> nodes;
+    std::vector<Edge> edges;
+    std::string labels;
+    unsigned path_count = 0;
+    bool compiled = false;
+
+    uint32_t new_node();
+    uint32_t key_child(uint32_t node, const uint8_t* key, unsigned len) const;
+    uint32_t index_child(uint32_t node, uint32_t index) const;
+};
+
+#endif
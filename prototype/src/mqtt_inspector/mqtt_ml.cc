@@ -36,6 +36,7 @@
 #include "log/messages.h"
 #include "profiler/profiler.h"
 
+#include "mqtt_demand.h"
 #include "mqtt_events.h"
 
 using namespace snort;
@@ -122,7 +123,7 @@ void MqttFeatureHandler::handle(DataEvent& de, Flow*)
 {
     Profile profile(mqtt_ml_prof);
     
-    const MqttFeatureEvent& fe = static_cast<const MqttFeatureEvent&>(de);
+    MqttFeatureEvent& fe = static_cast<MqttFeatureEvent&>(de);
     
     mqtt_ml_stats.events_received++;
     
@@ -173,10 +174,25 @@ void MqttFeatureHandler::handle(DataEvent& de, Flow*)
     if (mse >= inspector.get_threshold())
     {
         mqtt_ml_stats.anomalies_detected++;
+        fe.anomalous = 1;
         DetectionEngine::queue_event(MQTT_ML_GID, MQTT_ML_SID);
     }
 }
 
+//--------------------------------------------------------------------------
+// MQTT Keep-Alive Expiry Handler
+// A silent client sends no PDU to score, so the expiry is only counted here
+//--------------------------------------------------------------------------
+
+class MqttKeepaliveHandler : public DataHandler
+{
+public:
+    MqttKeepaliveHandler() : DataHandler(MQTT_ML_NAME) {}
+
+    void handle(DataEvent&, Flow*) override
+    { mqtt_ml_stats.keepalive_expired++; }
+};
+
 size_t MqttFeatureHandler::build_feature_vector(const MqttFeatureEvent& fe, 
                                                  float* features, 
                                                  size_t max_features)
@@ -249,11 +265,12 @@ size_t MqttFeatureHandler::build_feature_vector(const MqttFeatureEvent& fe,
     
     // ========== Timing Features ==========
     
-    // Feature 23: time_delta_us (unbounded) → log normalization
-    // This is time since first packet in flow (microseconds)
-    features[idx++] = normalize_log(static_cast<float>(fe.time_delta_us), MAX_TIME_DELTA_US);
+    // Feature 23: time since first packet in flow (unbounded) → log normalization
+    // The current model was trained with this in slot 23; fe.time_delta_us now
+    // carries the real inter-arrival time and waits for the next model version
+    features[idx++] = normalize_log(static_cast<float>(fe.time_relative_us), MAX_TIME_DELTA_US);
     
-    // Feature 24: time_relative_us (same as delta, included for compatibility)
+    // Feature 24: time_relative_us (time since first packet in flow)
     features[idx++] = normalize_log(static_cast<float>(fe.time_relative_us), MAX_TIME_DELTA_US);
     
     // ========== Brute Force Detection Features ==========
@@ -281,6 +298,9 @@ size_t MqttFeatureHandler::build_feature_vector(const MqttFeatureEvent& fe,
 
 MqttML::~MqttML()
 {
+    if (feature_demand)
+        mqtt_remove_demand(MQTT_DEMAND__FEATURES);
+
 #ifdef HAVE_TFLITE
     if (interpreter)
         TfLiteInterpreterDelete(interpreter);
@@ -410,11 +430,17 @@ bool MqttML::configure(SnortConfig*)
             LogMessage("mqtt_ml: ML anomaly detection active (threshold=%e)\n", threshold);
         else
             LogMessage("mqtt_ml: ML model not loaded, events will be counted but not scored\n");
+
+        // Without this the mqtt inspector does not build feature events
+        mqtt_add_demand(MQTT_DEMAND__FEATURES);
+        feature_demand = true;
     }
 
     // Subscribe to MQTT feature events
     DataBus::subscribe(mqtt_pub_key, MqttEventIds::MQTT_FEATURE,
         new MqttFeatureHandler(*this));
+    DataBus::subscribe(mqtt_pub_key, MqttEventIds::MQTT_KEEPALIVE_EXPIRY,
+        new MqttKeepaliveHandler);
 
     return true;
 }
@@ -50,6 +50,7 @@ public:
 private:
     MqttMLConfig conf;
     bool model_loaded = false;
+    bool feature_demand = false;    // Registered for MqttFeatureEvent
     float threshold = 0.5f;
 
     bool load_model();
@@ -72,6 +72,7 @@ static const PegInfo mqtt_ml_pegs[] =
     { CountType::SUM, "connect_packets", "CONNECT packets analyzed" },
     { CountType::SUM, "publish_packets", "PUBLISH packets analyzed" },
     { CountType::SUM, "other_packets", "other MQTT packets analyzed" },
+    { CountType::SUM, "keepalive_expired", "silent clients reported as their keep-alive ran out" },
     { CountType::END, nullptr, nullptr }
 };
 
@@ -41,6 +41,7 @@ struct MqttMLStats
     PegCount connect_packets;
     PegCount publish_packets;
     PegCount other_packets;
+    PegCount keepalive_expired;
 };
 
 extern THREAD_LOCAL MqttMLStats mqtt_ml_stats;
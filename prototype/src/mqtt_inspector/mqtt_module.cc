@@ -24,9 +24,15 @@
 
 #include "mqtt_module.h"
 
+#include "control/control.h"
+#include "log/messages.h"
+#include "main.h"
 #include "profiler/profiler.h"
 
 #include "mqtt.h"
+#include "mqtt_acl.h"
+#include "mqtt_heavy_hitters.h"
+#include "mqtt_topic_table.h"
 
 using namespace snort;
 
@@ -42,6 +48,67 @@ const PegInfo peg_names[] =
     { CountType::SUM, "frames", "total MQTT messages" },
     { CountType::NOW, "concurrent_sessions", "total concurrent mqtt sessions" },
     { CountType::MAX, "max_concurrent_sessions", "maximum concurrent mqtt sessions" },
+    { CountType::SUM, "qos2_handshakes", "QoS 2 handshakes started" },
+    { CountType::SUM, "qos2_completed", "QoS 2 handshakes completed with PUBCOMP" },
+    { CountType::SUM, "qos2_stalled", "QoS 2 handshakes that made no progress within the stall timeout" },
+    { CountType::SUM, "qos2_dup_ids", "QoS 2 PUBLISH reusing an in-flight packet identifier" },
+    { CountType::SUM, "qos2_unknown_ids", "PUBREC/PUBREL/PUBCOMP for an untracked packet identifier" },
+    { CountType::SUM, "qos2_table_full", "QoS 2 handshakes not tracked because the flow table was full" },
+    { CountType::SUM, "keepalive_expired", "clients silent for longer than the keep-alive limit" },
+    { CountType::SUM, "keepalive_trickle", "clients repeatedly sending just under the keep-alive limit" },
+    { CountType::SUM, "state_violations", "packets illegal in the current connection state" },
+    { CountType::SUM, "suback_mismatches", "SUBACK return code counts not matching their SUBSCRIBE" },
+    { CountType::SUM, "bad_flags", "packets with reserved fixed-header flags set wrong" },
+    { CountType::SUM, "bad_qos", "PUBLISH packets with QoS 3" },
+    { CountType::SUM, "bad_length_enc", "remaining length encodings that are not minimal or too long" },
+    { CountType::SUM, "length_mismatch", "packets whose remaining length disagrees with their size" },
+    { CountType::SUM, "bad_proto_id", "CONNECT packets with an unknown protocol name" },
+    { CountType::SUM, "bad_proto_level", "CONNECT packets whose protocol level does not match the name" },
+    { CountType::SUM, "bad_connect_flags", "CONNECT packets with reserved or contradictory flags" },
+    { CountType::SUM, "string_overrun", "length-prefixed fields running past the end of the packet" },
+    { CountType::SUM, "bad_property", "malformed MQTT 5 property blocks" },
+    { CountType::SUM, "v5_connects", "CONNECT packets for MQTT 5" },
+    { CountType::SUM, "auth_packets", "MQTT 5 AUTH packets" },
+    { CountType::SUM, "topic_alias_assigned", "MQTT 5 topic aliases assigned" },
+    { CountType::SUM, "topic_alias_resolved", "MQTT 5 PUBLISH topics resolved from an alias" },
+    { CountType::SUM, "topic_alias_errors", "MQTT 5 topic aliases out of range or never assigned" },
+    { CountType::SUM, "topic_alias_uncached", "MQTT 5 topic aliases past the configured limits" },
+    { CountType::SUM, "acl_publish_denied", "PUBLISH topics the topic ACL denies" },
+    { CountType::SUM, "acl_subscribe_denied", "SUBSCRIBE filters the topic ACL denies" },
+    { CountType::SUM, "acl_drops", "packets dropped for a topic ACL denial" },
+    { CountType::SUM, "json_scans", "PUBLISH payloads scanned for mqtt_payload_json paths" },
+    { CountType::SUM, "json_malformed", "scanned PUBLISH payloads that are not well-formed JSON" },
+    { CountType::SUM, "decompressed_payloads", "compressed PUBLISH payloads inflated" },
+    { CountType::SUM, "decompressed_bytes", "bytes inflated from compressed PUBLISH payloads" },
+    { CountType::SUM, "decompress_cap_hits", "inflated payloads cut at decompress_max" },
+    { CountType::SUM, "decompress_ratio_hits", "inflated payloads cut at decompress_ratio" },
+    { CountType::SUM, "decompress_errors", "compressed PUBLISH payloads that failed to inflate" },
+    { CountType::SUM, "sparkplug_payloads", "Sparkplug B payloads decoded" },
+    { CountType::SUM, "sparkplug_metrics", "metrics in decoded Sparkplug B payloads" },
+    { CountType::SUM, "sparkplug_malformed", "payloads on spBv1.0 topics that are not valid protobuf" },
+    { CountType::SUM, "bad_utf8", "packets with a topic, filter, client id or user name that is not valid UTF-8" },
+    { CountType::SUM, "topics_interned", "PUBLISH topics given an id in the topic table" },
+    { CountType::SUM, "topic_evictions", "least recently used topics evicted from the topic table" },
+    { CountType::SUM, "long_topics", "PUBLISH topics interned by prefix and hash" },
+    { CountType::SUM, "size_anomalies", "PUBLISH payload sizes past baseline_sigma of the topic baseline" },
+    { CountType::SUM, "interval_anomalies", "PUBLISH intervals past baseline_sigma of the topic baseline" },
+    { CountType::SUM, "payloads_profiled", "PUBLISH payloads profiled for content features" },
+    { CountType::SUM, "sources_evicted", "least recently seen sources replaced in the source table" },
+    { CountType::SUM, "client_id_replaced", "accepted CONNECTs reusing a client id another open flow holds" },
+    { CountType::SUM, "client_id_takeovers", "accepted CONNECTs taking a client id over from another source" },
+    { CountType::SUM, "client_id_flaps", "client ids past client_id_flap_limit source changes" },
+    { CountType::SUM, "client_id_refused_reuses", "refused CONNECTs naming a client id another open flow holds" },
+    { CountType::SUM, "client_registry_full", "CONNECTs whose client id did not fit the registry" },
+    { CountType::SUM, "connect_rate_alerts", "CONNECTs over the source rate that were only alerted on" },
+    { CountType::SUM, "connect_rate_drops", "CONNECTs over the source rate that were dropped" },
+    { CountType::SUM, "connect_rate_blocks", "CONNECTs over the source rate whose flow was blocked" },
+    { CountType::SUM, "trusted_flows", "flows that earned trust and left full inspection" },
+    { CountType::SUM, "trust_rearmed", "trusted flows put back under full inspection" },
+    { CountType::SUM, "trust_skipped_pdus", "PDUs of trusted flows that skipped detection in sample mode" },
+    { CountType::SUM, "trust_skipped_bytes", "bytes of trusted flows that skipped detection in sample mode" },
+    { CountType::SUM, "publish_deferred", "PUBLISH whose topic, properties and payload nothing asked for" },
+    { CountType::SUM, "publish_parsed_late", "deferred PUBLISH parsed when a rule asked for a buffer" },
+    { CountType::SUM, "features_skipped", "PDUs without a feature event since nothing subscribes" },
 
     { CountType::END, nullptr, nullptr }
 };
@@ -61,12 +128,74 @@ PegCount* MqttModule::get_counts() const
 
 #define MQTT_BAD_PROTO_ID_STR    "MQTT protocol name is invalid"
 #define MQTT_RESERVED_TYPE_STR   "reserved MQTT packet type in use"
+#define MQTT_QOS2_STALLED_STR    "MQTT QoS 2 handshake stalled"
+#define MQTT_QOS2_DUP_ID_STR     "MQTT QoS 2 PUBLISH reuses an in-flight packet identifier"
+#define MQTT_QOS2_TABLE_FULL_STR "MQTT QoS 2 in-flight limit exceeded"
+#define MQTT_KEEPALIVE_EXPIRED_STR "MQTT client exceeded its keep-alive interval"
+#define MQTT_KEEPALIVE_TRICKLE_STR "MQTT client keeps the session open just under the keep-alive limit"
+#define MQTT_CONNECT_NOT_FIRST_STR "MQTT packet before CONNECT/CONNACK"
+#define MQTT_DUPLICATE_CONNECT_STR "MQTT second CONNECT or CONNACK on a connection"
+#define MQTT_PKT_AFTER_REFUSED_STR "MQTT packet other than DISCONNECT after a refused CONNACK"
+#define MQTT_WRONG_DIRECTION_STR "MQTT packet type sent in the wrong direction"
+#define MQTT_PKT_AFTER_DISCONNECT_STR "MQTT client packet after DISCONNECT"
+#define MQTT_SUBACK_MISMATCH_STR "MQTT SUBACK return code count does not match SUBSCRIBE"
+#define MQTT_BAD_FLAGS_STR       "MQTT reserved fixed header flags are invalid"
+#define MQTT_BAD_QOS_STR         "MQTT PUBLISH with QoS 3"
+#define MQTT_BAD_LENGTH_ENC_STR  "MQTT remaining length encoding is not minimal or too long"
+#define MQTT_LENGTH_MISMATCH_STR "MQTT remaining length does not match the packet size"
+#define MQTT_BAD_PROTO_LEVEL_STR "MQTT protocol level does not match the protocol name"
+#define MQTT_BAD_CONNECT_FLAGS_STR "MQTT CONNECT flags are reserved or inconsistent"
+#define MQTT_STRING_OVERRUN_STR  "MQTT string length runs past the end of the packet"
+#define MQTT_BAD_PROPERTY_STR    "MQTT 5 property block is malformed"
+#define MQTT_BAD_TOPIC_ALIAS_STR "MQTT 5 topic alias is out of range or was never assigned"
+#define MQTT_ACL_PUBLISH_DENIED_STR "MQTT PUBLISH to a topic the client's ACL denies"
+#define MQTT_ACL_SUBSCRIBE_DENIED_STR "MQTT SUBSCRIBE to a filter the client's ACL denies"
+#define MQTT_BAD_UTF8_STR        "MQTT string is not valid UTF-8 or contains U+0000"
+#define MQTT_TOPIC_SIZE_ANOMALY_STR "MQTT PUBLISH payload size far from the topic baseline"
+#define MQTT_TOPIC_INTERVAL_ANOMALY_STR "MQTT PUBLISH interval far from the topic baseline"
+#define MQTT_SOURCE_USERNAMES_STR "MQTT source tried too many distinct user names"
+#define MQTT_SOURCE_PASSWORDS_STR "MQTT source tried too many distinct passwords"
+#define MQTT_SOURCE_CLIENT_IDS_STR "MQTT source used too many distinct client ids"
+#define MQTT_CLIENT_ID_TAKEOVER_STR "MQTT client id taken over by a connection from another source"
+#define MQTT_CLIENT_ID_FLAPPING_STR "MQTT client id alternating between sources"
+#define MQTT_CONNECT_RATE_STR    "MQTT CONNECT rate of the source exceeded"
 
 static const RuleMap mqtt_rules[] =
 {
     { MQTT_BAD_LENGTH, MQTT_BAD_LENGTH_STR },
     { MQTT_BAD_PROTO_ID, MQTT_BAD_PROTO_ID_STR },
     { MQTT_RESERVED_TYPE, MQTT_RESERVED_TYPE_STR },
+    { MQTT_QOS2_STALLED, MQTT_QOS2_STALLED_STR },
+    { MQTT_QOS2_DUP_ID, MQTT_QOS2_DUP_ID_STR },
+    { MQTT_QOS2_TABLE_FULL, MQTT_QOS2_TABLE_FULL_STR },
+    { MQTT_KEEPALIVE_EXPIRED, MQTT_KEEPALIVE_EXPIRED_STR },
+    { MQTT_KEEPALIVE_TRICKLE, MQTT_KEEPALIVE_TRICKLE_STR },
+    { MQTT_CONNECT_NOT_FIRST, MQTT_CONNECT_NOT_FIRST_STR },
+    { MQTT_DUPLICATE_CONNECT, MQTT_DUPLICATE_CONNECT_STR },
+    { MQTT_PKT_AFTER_REFUSED, MQTT_PKT_AFTER_REFUSED_STR },
+    { MQTT_WRONG_DIRECTION, MQTT_WRONG_DIRECTION_STR },
+    { MQTT_PKT_AFTER_DISCONNECT, MQTT_PKT_AFTER_DISCONNECT_STR },
+    { MQTT_SUBACK_MISMATCH, MQTT_SUBACK_MISMATCH_STR },
+    { MQTT_BAD_FLAGS, MQTT_BAD_FLAGS_STR },
+    { MQTT_BAD_QOS, MQTT_BAD_QOS_STR },
+    { MQTT_BAD_LENGTH_ENC, MQTT_BAD_LENGTH_ENC_STR },
+    { MQTT_LENGTH_MISMATCH, MQTT_LENGTH_MISMATCH_STR },
+    { MQTT_BAD_PROTO_LEVEL, MQTT_BAD_PROTO_LEVEL_STR },
+    { MQTT_BAD_CONNECT_FLAGS, MQTT_BAD_CONNECT_FLAGS_STR },
+    { MQTT_STRING_OVERRUN, MQTT_STRING_OVERRUN_STR },
+    { MQTT_BAD_PROPERTY, MQTT_BAD_PROPERTY_STR },
+    { MQTT_BAD_TOPIC_ALIAS, MQTT_BAD_TOPIC_ALIAS_STR },
+    { MQTT_ACL_PUBLISH_DENIED, MQTT_ACL_PUBLISH_DENIED_STR },
+    { MQTT_ACL_SUBSCRIBE_DENIED, MQTT_ACL_SUBSCRIBE_DENIED_STR },
+    { MQTT_BAD_UTF8, MQTT_BAD_UTF8_STR },
+    { MQTT_TOPIC_SIZE_ANOMALY, MQTT_TOPIC_SIZE_ANOMALY_STR },
+    { MQTT_TOPIC_INTERVAL_ANOMALY, MQTT_TOPIC_INTERVAL_ANOMALY_STR },
+    { MQTT_SOURCE_USERNAMES, MQTT_SOURCE_USERNAMES_STR },
+    { MQTT_SOURCE_PASSWORDS, MQTT_SOURCE_PASSWORDS_STR },
+    { MQTT_SOURCE_CLIENT_IDS, MQTT_SOURCE_CLIENT_IDS_STR },
+    { MQTT_CLIENT_ID_TAKEOVER, MQTT_CLIENT_ID_TAKEOVER_STR },
+    { MQTT_CLIENT_ID_FLAPPING, MQTT_CLIENT_ID_FLAPPING_STR },
+    { MQTT_CONNECT_RATE, MQTT_CONNECT_RATE_STR },
 
     { 0, nullptr }
 };
@@ -74,10 +203,285 @@ static const RuleMap mqtt_rules[] =
 const RuleMap* MqttModule::get_rules() const
 { return mqtt_rules; }
 
+//-------------------------------------------------------------------------
+// commands
+//-------------------------------------------------------------------------
+
+// Packet threads pick up the new ACLs on their next PDU; a file that does
+// not load leaves that inspector's ACL in place
+static int reload_acl(lua_State*)
+{
+    MqttAclBinding::reload_all();
+    return 0;
+}
+
+// Each packet thread adds the checks it counted
+static int acl_stats(lua_State* L)
+{
+    main_broadcast_command(new MqttAclStatsCommand, ControlConn::query_from_lua(L));
+    return 0;
+}
+
+// Each packet thread logs its own table
+static int dump_topics(lua_State* L)
+{
+    main_broadcast_command(new MqttTopicDumpCommand, ControlConn::query_from_lua(L));
+    return 0;
+}
+
+// Merges the heavy hitters of every packet thread into one list
+static int heavy_hitters(lua_State* L)
+{
+    main_broadcast_command(new MqttHeavyHitterCommand, ControlConn::query_from_lua(L));
+    return 0;
+}
+
+static const Command mqtt_cmds[] =
+{
+    { "reload_acl", reload_acl, nullptr, "reload the MQTT topic ACL file" },
+    { "acl_stats", acl_stats, nullptr, "log the checks and denials of each MQTT ACL policy" },
+    { "dump_topics", dump_topics, nullptr, "log the busiest MQTT topics of each packet thread" },
+    { "heavy_hitters", heavy_hitters, nullptr, "log the busiest MQTT sources, client ids and topics" },
+    { nullptr, nullptr, nullptr, nullptr }
+};
+
+const Command* MqttModule::get_commands() const
+{ return mqtt_cmds; }
+
 //-------------------------------------------------------------------------
 // params
 //-------------------------------------------------------------------------
 
+static const Parameter mqtt_params[] =
+{
+    { "qos2_max_inflight", Parameter::PT_INT, "1:4096", "64",
+      "maximum number of outstanding QoS 2 handshakes tracked per flow" },
+
+    { "qos2_stall_timeout", Parameter::PT_INT, "0:max32", "30",
+      "seconds without progress before a QoS 2 handshake counts as stalled (0 = disabled)" },
+
+    { "keepalive_factor", Parameter::PT_REAL, "0.0:100.0", "1.5",
+      "client silence allowed as a multiple of the CONNECT keep-alive (0 = disabled)" },
+
+    { "keepalive_trickle_count", Parameter::PT_INT, "0:max32", "3",
+      "consecutive client gaps between keep-alive and the limit that raise an event (0 = disabled)" },
+
+    { "topic_alias_max", Parameter::PT_INT, "0:1024", "16",
+      "MQTT 5 topic aliases resolved per flow and direction (0 = disabled)" },
+
+    { "topic_alias_max_len", Parameter::PT_INT, "1:4096", "256",
+      "longest topic kept for an MQTT 5 topic alias" },
+
+    { "acl_file", Parameter::PT_STRING, nullptr, nullptr,
+      "file of per client identity topic ACL rules" },
+
+    { "acl_drop", Parameter::PT_BOOL, nullptr, "false",
+      "drop PUBLISH and SUBSCRIBE packets the topic ACL denies" },
+
+    { "decompress", Parameter::PT_BOOL, nullptr, "false",
+      "inflate zlib and gzip PUBLISH payloads for the mqtt_payload_decompressed buffer" },
+
+    { "decompress_max", Parameter::PT_INT, "1024:1048576", "65536",
+      "maximum bytes inflated from one PUBLISH payload" },
+
+    { "decompress_ratio", Parameter::PT_INT, "1:10000", "100",
+      "maximum ratio of inflated to compressed payload size" },
+
+    { "sparkplug", Parameter::PT_BOOL, nullptr, "true",
+      "decode Sparkplug B payloads of PUBLISH packets on spBv1.0 topics" },
+
+    { "topic_table_memcap", Parameter::PT_INT, "0:268435456", "1048576",
+      "bytes per packet thread for interned PUBLISH topics and their counters (0 = off)" },
+
+    { "baseline_sigma", Parameter::PT_REAL, "0.0:1000.0", "6.0",
+      "standard deviations from a topic's payload size or publish interval baseline that alert (0 = off)" },
+
+    { "baseline_min_samples", Parameter::PT_INT, "2:1000000", "32",
+      "PUBLISH seen on a topic before its baselines alert" },
+
+    { "payload_profile", Parameter::PT_BOOL, nullptr, "false",
+      "add entropy and byte class features of PUBLISH payloads to the feature event" },
+
+    { "payload_profile_len", Parameter::PT_INT, "16:65535", "1024",
+      "bytes at the start of a PUBLISH payload that are profiled" },
+
+    { "heavy_hitters", Parameter::PT_INT, "0:4096", "64",
+      "counters per packet thread for the busiest sources, client ids and topics (0 = off)" },
+
+    { "heavy_hitter_interval", Parameter::PT_INT, "0:86400", "0",
+      "seconds between heavy hitter log lines, each restarting the counts (0 = never)" },
+
+    { "source_table_size", Parameter::PT_INT, "0:1048576", "4096",
+      "sources whose distinct CONNECT user names, passwords and client ids are estimated (0 = off)" },
+
+    { "source_window", Parameter::PT_INT, "1:86400", "300",
+      "seconds without a CONNECT after which a source's distinct counts start over" },
+
+    { "distinct_username_limit", Parameter::PT_INT, "0:65535", "20",
+      "distinct user names from one source that alert (0 = never)" },
+
+    { "distinct_password_limit", Parameter::PT_INT, "0:65535", "20",
+      "distinct passwords from one source that alert (0 = never)" },
+
+    { "distinct_client_id_limit", Parameter::PT_INT, "0:65535", "50",
+      "distinct client ids from one source that alert (0 = never)" },
+
+    { "client_registry_size", Parameter::PT_INT, "0:4194304", "16384",
+      "client ids of open flows tracked across packet threads (0 = off)" },
+
+    { "client_id_flap_window", Parameter::PT_INT, "1:86400", "60",
+      "seconds within which changes of a client id's source add up" },
+
+    { "client_id_flap_limit", Parameter::PT_INT, "0:65535", "3",
+      "source changes of a client id within the window that alert (0 = never)" },
+
+    { "connect_rate", Parameter::PT_REAL, "0.0:100000.0", "0.0",
+      "CONNECTs per second allowed from one source (0 = no limit)" },
+
+    { "connect_burst", Parameter::PT_INT, "1:65535", "20",
+      "CONNECTs one source may send at once before connect_rate applies" },
+
+    { "connect_rate_buckets", Parameter::PT_INT, "2:16777216", "65536",
+      "token buckets shared by all sources for connect_rate" },
+
+    { "connect_rate_action", Parameter::PT_ENUM, "alert | drop | block", "alert",
+      "what to do with a CONNECT over connect_rate" },
+
+    { "trust", Parameter::PT_ENUM, "off | bypass | sample", "off",
+      "stop inspecting connected flows that stayed clean: entirely, or all but sampled PDUs" },
+
+    { "trust_after_packets", Parameter::PT_INT, "0:max32", "1000",
+      "PDUs without violations or anomalies that earn a flow trust (0 = not by count)" },
+
+    { "trust_after_seconds", Parameter::PT_INT, "0:86400", "0",
+      "seconds without violations or anomalies that earn a flow trust (0 = not by time)" },
+
+    { "trust_sample", Parameter::PT_INT, "1:max32", "100",
+      "one PDU in this many of a trusted flow is inspected in full in sample mode" },
+
+    { "lazy_parse", Parameter::PT_BOOL, nullptr, "false",
+      "parse PUBLISH and build feature events only when rules, mqtt_ml or detectors use them; "
+      "other DataBus subscribers then stop getting them" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
 MqttModule::MqttModule() :
-    Module(MQTT_NAME, MQTT_HELP)
-{ }
+    Module(MQTT_NAME, MQTT_HELP, mqtt_params)
+{
+    conf.qos2_max_inflight = 64;
+    conf.qos2_stall_timeout = 30;
+    conf.keepalive_factor = 1.5;
+    conf.keepalive_trickle_count = 3;
+    conf.topic_alias_max = 16;
+    conf.topic_alias_max_len = 256;
+    conf.acl_drop = false;
+    conf.decompress = false;
+    conf.decompress_max = 65536;
+    conf.decompress_ratio = 100;
+    conf.sparkplug = true;
+    conf.topic_table_memcap = 1048576;
+    conf.baseline_sigma = 6.0;
+    conf.baseline_min_samples = 32;
+    conf.payload_profile = false;
+    conf.payload_profile_len = 1024;
+    conf.heavy_hitters = 64;
+    conf.heavy_hitter_interval = 0;
+    conf.source_table_size = 4096;
+    conf.source_window = 300;
+    conf.distinct_username_limit = 20;
+    conf.distinct_password_limit = 20;
+    conf.distinct_client_id_limit = 50;
+    conf.client_registry_size = 16384;
+    conf.client_id_flap_window = 60;
+    conf.client_id_flap_limit = 3;
+    conf.connect_rate = 0.0;
+    conf.connect_burst = 20;
+    conf.connect_rate_buckets = 65536;
+    conf.connect_rate_action = MQTT_RATE_ACTION__ALERT;
+    conf.trust = MQTT_TRUST__OFF;
+    conf.trust_after_packets = 1000;
+    conf.trust_after_seconds = 0;
+    conf.trust_sample = 100;
+    conf.lazy_parse = false;
+}
+
+bool MqttModule::set(const char*, Value& v, SnortConfig*)
+{
+    if (v.is("qos2_max_inflight"))
+        conf.qos2_max_inflight = v.get_uint32();
+    else if (v.is("qos2_stall_timeout"))
+        conf.qos2_stall_timeout = v.get_uint32();
+    else if (v.is("keepalive_factor"))
+        conf.keepalive_factor = v.get_real();
+    else if (v.is("keepalive_trickle_count"))
+        conf.keepalive_trickle_count = v.get_uint32();
+    else if (v.is("topic_alias_max"))
+        conf.topic_alias_max = v.get_uint32();
+    else if (v.is("topic_alias_max_len"))
+        conf.topic_alias_max_len = v.get_uint32();
+    else if (v.is("acl_file"))
+        conf.acl_file = v.get_string();
+    else if (v.is("acl_drop"))
+        conf.acl_drop = v.get_bool();
+    else if (v.is("decompress"))
+        conf.decompress = v.get_bool();
+    else if (v.is("decompress_max"))
+        conf.decompress_max = v.get_uint32();
+    else if (v.is("decompress_ratio"))
+        conf.decompress_ratio = v.get_uint32();
+    else if (v.is("sparkplug"))
+        conf.sparkplug = v.get_bool();
+    else if (v.is("topic_table_memcap"))
+        conf.topic_table_memcap = v.get_uint32();
+    else if (v.is("baseline_sigma"))
+        conf.baseline_sigma = v.get_real();
+    else if (v.is("baseline_min_samples"))
+        conf.baseline_min_samples = v.get_uint32();
+    else if (v.is("payload_profile"))
+        conf.payload_profile = v.get_bool();
+    else if (v.is("payload_profile_len"))
+        conf.payload_profile_len = v.get_uint32();
+    else if (v.is("heavy_hitters"))
+        conf.heavy_hitters = v.get_uint32();
+    else if (v.is("heavy_hitter_interval"))
+        conf.heavy_hitter_interval = v.get_uint32();
+    else if (v.is("source_table_size"))
+        conf.source_table_size = v.get_uint32();
+    else if (v.is("source_window"))
+        conf.source_window = v.get_uint32();
+    else if (v.is("distinct_username_limit"))
+        conf.distinct_username_limit = v.get_uint32();
+    else if (v.is("distinct_password_limit"))
+        conf.distinct_password_limit = v.get_uint32();
+    else if (v.is("distinct_client_id_limit"))
+        conf.distinct_client_id_limit = v.get_uint32();
+    else if (v.is("client_registry_size"))
+        conf.client_registry_size = v.get_uint32();
+    else if (v.is("client_id_flap_window"))
+        conf.client_id_flap_window = v.get_uint32();
+    else if (v.is("client_id_flap_limit"))
+        conf.client_id_flap_limit = v.get_uint32();
+    else if (v.is("connect_rate"))
+        conf.connect_rate = v.get_real();
+    else if (v.is("connect_burst"))
+        conf.connect_burst = v.get_uint32();
+    else if (v.is("connect_rate_buckets"))
+        conf.connect_rate_buckets = v.get_uint32();
+    else if (v.is("connect_rate_action"))
+        conf.connect_rate_action = static_cast<mqtt_rate_action_t>(v.get_uint8());
+    else if (v.is("trust"))
+        conf.trust = static_cast<mqtt_trust_mode_t>(v.get_uint8());
+    else if (v.is("trust_after_packets"))
+        conf.trust_after_packets = v.get_uint32();
+    else if (v.is("trust_after_seconds"))
+        conf.trust_after_seconds = v.get_uint32();
+    else if (v.is("trust_sample"))
+        conf.trust_sample = v.get_uint32();
+    else if (v.is("lazy_parse"))
+        conf.lazy_parse = v.get_bool();
+    else
+        return false;
+
+    return true;
+}
@@ -21,6 +21,8 @@
 #ifndef MQTT_MODULE_H
 #define MQTT_MODULE_H
 
+#include <string>
+
 #include "framework/module.h"
 
 // GID for MQTT inspector (pick unused number)
@@ -30,11 +32,98 @@
 #define MQTT_BAD_LENGTH      1
 #define MQTT_BAD_PROTO_ID    2
 #define MQTT_RESERVED_TYPE   3
+#define MQTT_QOS2_STALLED    4
+#define MQTT_QOS2_DUP_ID     5
+#define MQTT_QOS2_TABLE_FULL 6
+#define MQTT_KEEPALIVE_EXPIRED 7
+#define MQTT_KEEPALIVE_TRICKLE 8
+#define MQTT_CONNECT_NOT_FIRST 9
+#define MQTT_DUPLICATE_CONNECT 10
+#define MQTT_PKT_AFTER_REFUSED 11
+#define MQTT_WRONG_DIRECTION 12
+#define MQTT_PKT_AFTER_DISCONNECT 13
+#define MQTT_SUBACK_MISMATCH 14
+#define MQTT_BAD_FLAGS       15
+#define MQTT_BAD_QOS         16
+#define MQTT_BAD_LENGTH_ENC  17
+#define MQTT_LENGTH_MISMATCH 18
+#define MQTT_BAD_PROTO_LEVEL 19
+#define MQTT_BAD_CONNECT_FLAGS 20
+#define MQTT_STRING_OVERRUN  21
+#define MQTT_BAD_PROPERTY    22
+#define MQTT_BAD_TOPIC_ALIAS 23
+#define MQTT_ACL_PUBLISH_DENIED 24
+#define MQTT_ACL_SUBSCRIBE_DENIED 25
+#define MQTT_BAD_UTF8        26
+#define MQTT_TOPIC_SIZE_ANOMALY 27
+#define MQTT_TOPIC_INTERVAL_ANOMALY 28
+#define MQTT_SOURCE_USERNAMES 29
+#define MQTT_SOURCE_PASSWORDS 30
+#define MQTT_SOURCE_CLIENT_IDS 31
+#define MQTT_CLIENT_ID_TAKEOVER 32
+#define MQTT_CLIENT_ID_FLAPPING 33
+#define MQTT_CONNECT_RATE    34
 
 // Module name and help text
 #define MQTT_NAME "mqtt"
 #define MQTT_HELP "mqtt inspection"
 
+// What happens to a CONNECT over the per-source rate
+enum mqtt_rate_action_t : uint8_t
+{
+    MQTT_RATE_ACTION__ALERT,
+    MQTT_RATE_ACTION__DROP,         // Drop the packet
+    MQTT_RATE_ACTION__BLOCK         // Block the flow
+};
+
+// How a flow that has earned trust is inspected from then on
+enum mqtt_trust_mode_t : uint8_t
+{
+    MQTT_TRUST__OFF,
+    MQTT_TRUST__BYPASS,             // Snort stops inspecting the flow for good
+    MQTT_TRUST__SAMPLE              // Only one PDU in trust_sample is inspected in full
+};
+
+struct MqttConfig
+{
+    uint32_t qos2_max_inflight;     // Per-flow capacity of the QoS 2 handshake table
+    uint32_t qos2_stall_timeout;    // Seconds without progress before a handshake is stalled
+    double keepalive_factor;        // Client silence allowed, as a multiple of keep_alive (0 = off)
+    uint32_t keepalive_trickle_count; // Consecutive late-but-allowed gaps that look like SlowITe
+    uint32_t topic_alias_max;       // Topic aliases kept per direction (0 = no resolution)
+    uint32_t topic_alias_max_len;   // Longest topic kept for an alias
+    std::string acl_file;           // Topic ACL policy file, empty = no ACL
+    bool acl_drop;                  // Drop PUBLISH/SUBSCRIBE the ACL denies
+    bool decompress;                // Serve mqtt_payload_decompressed
+    uint32_t decompress_max;        // Largest inflated payload, bytes
+    uint32_t decompress_ratio;      // Largest inflated / compressed size
+    bool sparkplug;                 // Decode Sparkplug B payloads on spBv1.0 topics
+    uint32_t topic_table_memcap;    // Per-thread topic table bytes, 0 = no table
+    double baseline_sigma;          // Deviation from a topic baseline that alerts (0 = off)
+    uint32_t baseline_min_samples;  // Samples a baseline needs before it alerts
+    bool payload_profile;           // Add payload content features to the feature event
+    uint32_t payload_profile_len;   // Payload prefix profiled, bytes
+    uint32_t heavy_hitters;         // Counters per heavy hitter summary, 0 = off
+    uint32_t heavy_hitter_interval; // Seconds between heavy hitter log lines, 0 = never
+    uint32_t source_table_size;     // Sources with distinct credential counts, 0 = off
+    uint32_t source_window;         // Seconds a silent source keeps its counts
+    uint32_t distinct_username_limit;   // Distinct values per source that alert (0 = off)
+    uint32_t distinct_password_limit;
+    uint32_t distinct_client_id_limit;
+    uint32_t client_registry_size;  // Client ids tracked across flows, 0 = off
+    uint32_t client_id_flap_window; // Seconds within which source changes add up
+    uint32_t client_id_flap_limit;  // Source changes within the window that alert (0 = off)
+    double connect_rate;            // CONNECTs per second allowed per source, 0 = no limit
+    uint32_t connect_burst;         // CONNECTs a source may send at once
+    uint32_t connect_rate_buckets;  // Token buckets shared by all sources
+    mqtt_rate_action_t connect_rate_action;
+    mqtt_trust_mode_t trust;
+    uint32_t trust_after_packets;   // Clean PDUs that earn trust, 0 = not by count
+    uint32_t trust_after_seconds;   // Clean time that earns trust, 0 = not by time
+    uint32_t trust_sample;          // One trusted PDU in this many is inspected in full
+    bool lazy_parse;                // Skip work no rule, mqtt_ml or detector consumes
+};
+
 // Profiling stats (declared here, defined in mqtt_module.cc)
 extern THREAD_LOCAL snort::ProfileStats mqtt_prof;
 
@@ -43,10 +132,16 @@ class MqttModule : public snort::Module
 public:
     MqttModule();
 
+    bool set(const char*, snort::Value&, snort::SnortConfig*) override;
+
+    const MqttConfig& get_config() const
+    { return conf; }
+
     unsigned get_gid() const override
     { return GID_MQTT; }
 
     const snort::RuleMap* get_rules() const override;
+    const snort::Command* get_commands() const override;
 
     const PegInfo* get_pegs() const override;
     PegCount* get_counts() const override;
@@ -59,6 +154,9 @@ public:
 
     bool is_bindable() const override
     { return true; }
+
+private:
+    MqttConfig conf = {};
 };
 
 #endif
@@ -0,0 +1,53 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_payload_profile.h author Zhinoo Zobairi
+// Content features of a PUBLISH payload prefix: entropy and byte classes.
+
+#ifndef MQTT_PAYLOAD_PROFILE_H
+#define MQTT_PAYLOAD_PROFILE_H
+
+#include <cstdint>
+
+// Largest prefix profiled, so every class count fits its uint16_t
+#define MQTT_PROFILE_MAX_LEN 65535
+
+enum mqtt_byte_class_t : uint8_t
+{
+    MQTT_BYTE_CLASS__NUL,
+    MQTT_BYTE_CLASS__CONTROL,       // 0x01-0x1F and 0x7F, except whitespace
+    MQTT_BYTE_CLASS__SPACE,         // Tab, LF, CR and space
+    MQTT_BYTE_CLASS__DIGIT,
+    MQTT_BYTE_CLASS__ALPHA,
+    MQTT_BYTE_CLASS__PUNCT,         // Other printable ASCII
+    MQTT_BYTE_CLASS__HIGH,          // 0x80-0xFF
+    MQTT_BYTE_CLASS__MAX
+};
+
+struct MqttPayloadProfile
+{
+    float entropy;                  // Shannon entropy, bits per byte (0-8)
+    float printable;                // Share of whitespace and printable ASCII
+    uint16_t classes[MQTT_BYTE_CLASS__MAX];
+};
+
+// Profiles the first len bytes of data; len must not exceed
+// MQTT_PROFILE_MAX_LEN, so the cost is bounded whatever the payload size
+void mqtt_profile_payload(const uint8_t* data, unsigned len, MqttPayloadProfile&);
+
+#endif
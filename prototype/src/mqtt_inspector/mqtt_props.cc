@@ -0,0 +1,247 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_props.cc author Zhinoo Zobairi
+// MQTT 5.0 property block parsing.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mqtt_props.h"
+
+// Value encodings, MQTT 5.0 section 1.5
+enum mqtt_prop_type_t : uint8_t
+{
+    MQTT_PROP_TYPE__NONE,           // Not a valid identifier
+    MQTT_PROP_TYPE__BYTE,
+    MQTT_PROP_TYPE__TWO,
+    MQTT_PROP_TYPE__FOUR,
+    MQTT_PROP_TYPE__VARINT,
+    MQTT_PROP_TYPE__STRING,         // UTF-8 string or binary data, 2-byte length prefix
+    MQTT_PROP_TYPE__PAIR            // Two strings
+};
+
+static const uint8_t prop_types[MQTT_PROP__MAX] =
+{
+    MQTT_PROP_TYPE__NONE,           // 0x00
+    MQTT_PROP_TYPE__BYTE,           // 0x01 payload format indicator
+    MQTT_PROP_TYPE__FOUR,           // 0x02 message expiry interval
+    MQTT_PROP_TYPE__STRING,         // 0x03 content type
+    MQTT_PROP_TYPE__NONE,
+    MQTT_PROP_TYPE__NONE,
+    MQTT_PROP_TYPE__NONE,
+    MQTT_PROP_TYPE__NONE,
+    MQTT_PROP_TYPE__STRING,         // 0x08 response topic
+    MQTT_PROP_TYPE__STRING,         // 0x09 correlation data
+    MQTT_PROP_TYPE__NONE,
+    MQTT_PROP_TYPE__VARINT,         // 0x0B subscription identifier
+    MQTT_PROP_TYPE__NONE,
+    MQTT_PROP_TYPE__NONE,
+    MQTT_PROP_TYPE__NONE,
+    MQTT_PROP_TYPE__NONE,
+    MQTT_PROP_TYPE__NONE,
+    MQTT_PROP_TYPE__FOUR,           // 0x11 session expiry interval
+    MQTT_PROP_TYPE__STRING,         // 0x12 assigned client identifier
+    MQTT_PROP_TYPE__TWO,            // 0x13 server keep alive
+    MQTT_PROP_TYPE__NONE,
+    MQTT_PROP_TYPE__STRING,         // 0x15 authentication method
+    MQTT_PROP_TYPE__STRING,         // 0x16 authentication data
+    MQTT_PROP_TYPE__BYTE,           // 0x17 request problem information
+    MQTT_PROP_TYPE__FOUR,           // 0x18 will delay interval
+    MQTT_PROP_TYPE__BYTE,           // 0x19 request response information
+    MQTT_PROP_TYPE__STRING,         // 0x1A response information
+    MQTT_PROP_TYPE__NONE,
+    MQTT_PROP_TYPE__STRING,         // 0x1C server reference
+    MQTT_PROP_TYPE__NONE,
+    MQTT_PROP_TYPE__NONE,
+    MQTT_PROP_TYPE__STRING,         // 0x1F reason string
+    MQTT_PROP_TYPE__NONE,
+    MQTT_PROP_TYPE__TWO,            // 0x21 receive maximum
+    MQTT_PROP_TYPE__TWO,            // 0x22 topic alias maximum
+    MQTT_PROP_TYPE__TWO,            // 0x23 topic alias
+    MQTT_PROP_TYPE__BYTE,           // 0x24 maximum QoS
+    MQTT_PROP_TYPE__BYTE,           // 0x25 retain available
+    MQTT_PROP_TYPE__PAIR,           // 0x26 user property
+    MQTT_PROP_TYPE__FOUR,           // 0x27 maximum packet size
+    MQTT_PROP_TYPE__BYTE,           // 0x28 wildcard subscription available
+    MQTT_PROP_TYPE__BYTE,           // 0x29 subscription identifier available
+    MQTT_PROP_TYPE__BYTE,           // 0x2A shared subscription available
+};
+
+bool mqtt_read_varint(const uint8_t* data, uint16_t dsize, int& offset, uint32_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 28; shift += 7)
+    {
+        if (offset >= dsize)
+            return false;
+        uint8_t byte = data[offset++];
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+static inline bool skip_string(const uint8_t* data, int end, int& offset, uint16_t& len)
+{
+    if (offset + 2 > end)
+        return false;
+    len = (data[offset] << 8) | data[offset + 1];
+    offset += 2 + len;
+    return offset <= end;
+}
+
+bool MqttPropIndex::parse(const uint8_t* data, uint16_t dsize, int& offset)
+{
+    uint32_t block_len;
+    if (!mqtt_read_varint(data, dsize, offset, block_len) || offset + block_len > dsize)
+        return false;
+
+    pdu = data;
+    start = offset;
+    len = block_len;
+
+    int end = offset + block_len;
+    bool ok = true;
+
+    while (offset < end)
+    {
+        uint8_t id = data[offset++];
+        uint8_t type = id < MQTT_PROP__MAX ? prop_types[id] : uint8_t(MQTT_PROP_TYPE__NONE);
+        uint16_t value_off = offset;
+        uint16_t slen;
+
+        switch (type)
+        {
+        case MQTT_PROP_TYPE__BYTE:
+            offset += 1;
+            break;
+        case MQTT_PROP_TYPE__TWO:
+            offset += 2;
+            break;
+        case MQTT_PROP_TYPE__FOUR:
+            offset += 4;
+            break;
+        case MQTT_PROP_TYPE__VARINT:
+        {
+            uint32_t v;
+            if (!mqtt_read_varint(data, end, offset, v))
+                offset = end + 1;
+            break;
+        }
+        case MQTT_PROP_TYPE__STRING:
+            if (!skip_string(data, end, offset, slen))
+                offset = end + 1;
+            break;
+        case MQTT_PROP_TYPE__PAIR:
+        {
+            uint16_t vlen;
+            if (!skip_string(data, end, offset, slen) || !skip_string(data, end, offset, vlen))
+                offset = end + 1;
+            else
+            {
+                user_count++;
+                user_bytes += slen + vlen;
+            }
+            break;
+        }
+        default:
+            offset = end + 1;
+            break;
+        }
+
+        if (offset > end)
+        {
+            // Skip whatever is left so the caller can carry on after the block
+            offset = end;
+            return false;
+        }
+
+        // User properties and, in PUBLISH, subscription identifiers may repeat;
+        // only the first one is indexed
+        if (find(id))
+        {
+            if (id != MQTT_PROP__USER_PROPERTY && id != MQTT_PROP__SUBSCRIPTION_ID)
+                ok = false;
+            continue;
+        }
+
+        if (count < MQTT_PROPS_MAX)
+        {
+            index[count].id = id;
+            index[count].offset = value_off;
+            count++;
+        }
+    }
+
+    return ok;
+}
+
+const mqtt_prop_t* MqttPropIndex::find(uint8_t id) const
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (index[i].id == id)
+            return &index[i];
+    }
+    return nullptr;
+}
+
+uint32_t MqttPropIndex::get_int(uint8_t id, uint32_t dflt) const
+{
+    const mqtt_prop_t* prop = find(id);
+    if (!prop)
+        return dflt;
+
+    const uint8_t* v = pdu + prop->offset;
+
+    switch (prop_types[id])
+    {
+    case MQTT_PROP_TYPE__BYTE:
+        return v[0];
+    case MQTT_PROP_TYPE__TWO:
+        return (v[0] << 8) | v[1];
+    case MQTT_PROP_TYPE__FOUR:
+        return (static_cast<uint32_t>(v[0]) << 24) | (v[1] << 16) | (v[2] << 8) | v[3];
+    case MQTT_PROP_TYPE__VARINT:
+    {
+        int off = prop->offset;
+        uint32_t value;
+        return mqtt_read_varint(pdu, start + len, off, value) ? value : dflt;
+    }
+    }
+    return dflt;
+}
+
+bool MqttPropIndex::get_string(uint8_t id, const uint8_t*& str, uint16_t& slen) const
+{
+    const mqtt_prop_t* prop = find(id);
+    if (!prop)
+        return false;
+
+    uint8_t type = prop_types[id];
+    if (type != MQTT_PROP_TYPE__STRING && type != MQTT_PROP_TYPE__PAIR)
+        return false;
+
+    const uint8_t* v = pdu + prop->offset;
+    slen = (v[0] << 8) | v[1];
+    str = v + 2;
+    return true;
+}
@@ -0,0 +1,104 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_props.h author Zhinoo Zobairi
+// MQTT 5.0 property block parsing (MQTT 5.0 section 2.2.2).
+
+#ifndef MQTT_PROPS_H
+#define MQTT_PROPS_H
+
+#include <cstdint>
+
+// Property identifiers, MQTT 5.0 table 2-4
+enum mqtt_prop_id_t : uint8_t
+{
+    MQTT_PROP__PAYLOAD_FORMAT         = 0x01,
+    MQTT_PROP__MESSAGE_EXPIRY         = 0x02,
+    MQTT_PROP__CONTENT_TYPE           = 0x03,
+    MQTT_PROP__RESPONSE_TOPIC         = 0x08,
+    MQTT_PROP__CORRELATION_DATA       = 0x09,
+    MQTT_PROP__SUBSCRIPTION_ID        = 0x0B,
+    MQTT_PROP__SESSION_EXPIRY         = 0x11,
+    MQTT_PROP__ASSIGNED_CLIENT_ID     = 0x12,
+    MQTT_PROP__SERVER_KEEP_ALIVE      = 0x13,
+    MQTT_PROP__AUTH_METHOD            = 0x15,
+    MQTT_PROP__AUTH_DATA              = 0x16,
+    MQTT_PROP__REQUEST_PROBLEM_INFO   = 0x17,
+    MQTT_PROP__WILL_DELAY             = 0x18,
+    MQTT_PROP__REQUEST_RESPONSE_INFO  = 0x19,
+    MQTT_PROP__RESPONSE_INFO          = 0x1A,
+    MQTT_PROP__SERVER_REFERENCE       = 0x1C,
+    MQTT_PROP__REASON_STRING          = 0x1F,
+    MQTT_PROP__RECEIVE_MAXIMUM        = 0x21,
+    MQTT_PROP__TOPIC_ALIAS_MAXIMUM    = 0x22,
+    MQTT_PROP__TOPIC_ALIAS            = 0x23,
+    MQTT_PROP__MAXIMUM_QOS            = 0x24,
+    MQTT_PROP__RETAIN_AVAILABLE       = 0x25,
+    MQTT_PROP__USER_PROPERTY          = 0x26,
+    MQTT_PROP__MAXIMUM_PACKET_SIZE    = 0x27,
+    MQTT_PROP__WILDCARD_SUB_AVAILABLE = 0x28,
+    MQTT_PROP__SUB_ID_AVAILABLE       = 0x29,
+    MQTT_PROP__SHARED_SUB_AVAILABLE   = 0x2A,
+    MQTT_PROP__MAX
+};
+
+// Distinct properties remembered per block; user properties share one slot
+#define MQTT_PROPS_MAX 16
+
+struct mqtt_prop_t
+{
+    uint8_t id;
+    uint16_t offset;                // Value offset from the start of the PDU
+};
+
+// Index of one property block. Nothing is copied: each entry records where
+// the value sits in the PDU, so lookups read straight from the packet.
+// Plain data, zeroed together with the rest of the per-PDU state.
+struct MqttPropIndex
+{
+    const uint8_t* pdu;             // PDU the offsets refer to, null = no block
+    uint16_t start;                 // First property byte
+    uint16_t len;                   // Property block length
+    uint16_t user_count;            // User properties, not capped
+    uint8_t count;
+    uint32_t user_bytes;            // Name and value bytes of all user properties
+    mqtt_prop_t index[MQTT_PROPS_MAX];
+
+    // Parses the block starting at offset (its variable byte length first)
+    // and moves offset past it. False when the block is malformed: unknown
+    // identifier, value past the end, or a non-repeatable property repeated.
+    // Properties indexed before the error stay usable.
+    bool parse(const uint8_t* data, uint16_t dsize, int& offset);
+
+    bool has(uint8_t id) const
+    { return find(id) != nullptr; }
+
+    // Byte, two and four byte integers and variable byte integers
+    uint32_t get_int(uint8_t id, uint32_t dflt = 0) const;
+
+    // UTF-8 strings and binary data; for a user property, the first name
+    bool get_string(uint8_t id, const uint8_t*& str, uint16_t& len) const;
+
+private:
+    const mqtt_prop_t* find(uint8_t id) const;
+};
+
+// Reads an MQTT variable byte integer (at most 4 bytes), moves offset past it
+bool mqtt_read_varint(const uint8_t* data, uint16_t dsize, int& offset, uint32_t& value);
+
+#endif
@@ -0,0 +1,275 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_qos2.cc author Zhinoo Zobairi
+// QoS 2 handshake tracking used to spot SlowITe-style broker exhaustion.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mqtt_qos2.h"
+
+#include <cstring>
+
+// Bit set in the table key when the PUBLISH came from the client
+#define QOS2_KEY_FROM_CLIENT 0x10000
+
+MqttQos2Tracker::MqttQos2Tracker(uint32_t max, uint64_t timeout_ns) :
+    max_inflight(max), stall_timeout_ns(timeout_ns)
+{ }
+
+MqttQos2Tracker::~MqttQos2Tracker()
+{
+    delete[] table;
+}
+
+bool MqttQos2Tracker::allocate()
+{
+    if (max_inflight == 0)
+        return false;
+
+    // Keep the load factor at or below 1/2 so probe sequences stay short
+    uint32_t size = 8;
+    while (size < 2 * max_inflight)
+        size <<= 1;
+
+    table = new mqtt_qos2_entry_t[size];
+    memset(table, 0, size * sizeof(*table));
+    mask = size - 1;
+    return true;
+}
+
+uint32_t MqttQos2Tracker::home(uint32_t key) const
+{
+    // Fibonacci hashing spreads sequential packet identifiers across the table
+    return ((key * 0x9E3779B1u) >> 16) & mask;
+}
+
+uint16_t MqttQos2Tracker::find(uint32_t key) const
+{
+    uint32_t i = home(key);
+
+    while (table[i].state != MQTT_QOS2_STATE__FREE)
+    {
+        if (table[i].key == key)
+            return i;
+        i = (i + 1) & mask;
+    }
+    return NIL;
+}
+
+uint16_t MqttQos2Tracker::insert(uint32_t key)
+{
+    if (inflight >= max_inflight)
+        return NIL;
+
+    uint32_t i = home(key);
+    while (table[i].state != MQTT_QOS2_STATE__FREE)
+        i = (i + 1) & mask;
+
+    table[i].key = key;
+    inflight++;
+    return i;
+}
+
+void MqttQos2Tracker::remove(uint16_t idx)
+{
+    unlink(idx);
+    table[idx].state = MQTT_QOS2_STATE__FREE;
+    inflight--;
+
+    // Backward-shift deletion: pull later members of the probe run into the
+    // hole so lookups never need tombstones
+    uint32_t hole = idx;
+    uint32_t j = (hole + 1) & mask;
+
+    while (table[j].state != MQTT_QOS2_STATE__FREE)
+    {
+        uint32_t h = home(table[j].key);
+
+        if (((j - h) & mask) >= ((j - hole) & mask))
+        {
+            table[hole] = table[j];
+            relink(j, hole);
+            table[j].state = MQTT_QOS2_STATE__FREE;
+            hole = j;
+        }
+        j = (j + 1) & mask;
+    }
+}
+
+//-------------------------------------------------------------------------
+// age list
+//-------------------------------------------------------------------------
+
+void MqttQos2Tracker::link_tail(uint16_t idx)
+{
+    mqtt_qos2_entry_t& e = table[idx];
+    e.prev = tail;
+    e.next = NIL;
+    e.stalled = 0;
+
+    if (tail != NIL)
+        table[tail].next = idx;
+    else
+        head = idx;
+    tail = idx;
+
+    // Everything before the cursor is stalled, so a fresh entry becomes the
+    // cursor when every other entry has already been counted
+    if (stall_cursor == NIL)
+        stall_cursor = idx;
+}
+
+void MqttQos2Tracker::unlink(uint16_t idx)
+{
+    mqtt_qos2_entry_t& e = table[idx];
+
+    if (e.stalled)
+        stalled--;
+
+    if (stall_cursor == idx)
+        stall_cursor = e.next;
+
+    if (e.prev != NIL)
+        table[e.prev].next = e.next;
+    else
+        head = e.next;
+
+    if (e.next != NIL)
+        table[e.next].prev = e.prev;
+    else
+        tail = e.prev;
+}
+
+// Entry was moved from slot 'from' to slot 'to', fix up everything pointing at it
+void MqttQos2Tracker::relink(uint16_t from, uint16_t to)
+{
+    mqtt_qos2_entry_t& e = table[to];
+
+    if (e.prev != NIL)
+        table[e.prev].next = to;
+    else
+        head = to;
+
+    if (e.next != NIL)
+        table[e.next].prev = to;
+    else
+        tail = to;
+
+    if (stall_cursor == from)
+        stall_cursor = to;
+}
+
+void MqttQos2Tracker::touch(uint16_t idx, uint8_t state, uint64_t now_ns)
+{
+    unlink(idx);
+    table[idx].state = state;
+    table[idx].ts_ns = now_ns;
+    link_tail(idx);
+}
+
+//-------------------------------------------------------------------------
+// handshake
+//-------------------------------------------------------------------------
+
+mqtt_qos2_result_t MqttQos2Tracker::update(uint8_t msg_type, uint16_t msg_id,
+    bool from_client, bool dup, uint64_t now_ns)
+{
+    if (!table && !allocate())
+        return MQTT_QOS2_RESULT__FULL;
+
+    // PUBLISH and PUBREL travel from the publisher, PUBREC and PUBCOMP back to it
+    bool publisher_is_client = (msg_type == 3 || msg_type == 6) ? from_client : !from_client;
+    uint32_t key = msg_id | (publisher_is_client ? QOS2_KEY_FROM_CLIENT : 0);
+    uint16_t idx = find(key);
+
+    switch (msg_type)
+    {
+    case 3:  // PUBLISH
+        if (idx != NIL)
+        {
+            // A retransmission must carry DUP=1, anything else reuses a live identifier
+            if (dup)
+                return MQTT_QOS2_RESULT__OK;
+            duplicates++;
+            return MQTT_QOS2_RESULT__DUPLICATE;
+        }
+        idx = insert(key);
+        if (idx == NIL)
+            return MQTT_QOS2_RESULT__FULL;
+        table[idx].state = MQTT_QOS2_STATE__PUBLISHED;
+        table[idx].ts_ns = now_ns;
+        link_tail(idx);
+        return MQTT_QOS2_RESULT__OK;
+
+    case 5:  // PUBREC
+        if (idx == NIL)
+            return MQTT_QOS2_RESULT__UNKNOWN;
+        if (table[idx].state == MQTT_QOS2_STATE__PUBLISHED)
+            touch(idx, MQTT_QOS2_STATE__RECEIVED, now_ns);
+        return MQTT_QOS2_RESULT__OK;
+
+    case 6:  // PUBREL
+        if (idx == NIL)
+            return MQTT_QOS2_RESULT__UNKNOWN;
+        if (table[idx].state != MQTT_QOS2_STATE__RELEASED)
+            touch(idx, MQTT_QOS2_STATE__RELEASED, now_ns);
+        return MQTT_QOS2_RESULT__OK;
+
+    case 7:  // PUBCOMP
+        if (idx == NIL)
+            return MQTT_QOS2_RESULT__UNKNOWN;
+        remove(idx);
+        return MQTT_QOS2_RESULT__OK;
+    }
+
+    return MQTT_QOS2_RESULT__OK;
+}
+
+uint32_t MqttQos2Tracker::check_stalled(uint64_t now_ns)
+{
+    if (!table || stall_timeout_ns == 0)
+        return 0;
+
+    // The age list is ordered by last transition, so stalled entries form a
+    // prefix and each one is visited once over its lifetime
+    uint32_t newly = 0;
+
+    while (stall_cursor != NIL)
+    {
+        mqtt_qos2_entry_t& e = table[stall_cursor];
+
+        if (now_ns < e.ts_ns || now_ns - e.ts_ns < stall_timeout_ns)
+            break;
+
+        e.stalled = 1;
+        stalled++;
+        newly++;
+        stall_cursor = e.next;
+    }
+    return newly;
+}
+
+int64_t MqttQos2Tracker::get_oldest_age_ns(uint64_t now_ns) const
+{
+    if (head == NIL || now_ns < table[head].ts_ns)
+        return 0;
+    return static_cast<int64_t>(now_ns - table[head].ts_ns);
+}
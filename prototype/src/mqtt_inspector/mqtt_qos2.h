@@ -0,0 +1,112 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_qos2.h author Zhinoo Zobairi
+// Per-flow tracker of in-flight QoS 2 handshakes (PUBLISH→PUBREC→PUBREL→PUBCOMP).
+
+#ifndef MQTT_QOS2_H
+#define MQTT_QOS2_H
+
+#include <cstdint>
+
+// Where a packet identifier currently is in the exactly-once handshake
+enum mqtt_qos2_state_t : uint8_t
+{
+    MQTT_QOS2_STATE__FREE,          // Slot unused
+    MQTT_QOS2_STATE__PUBLISHED,     // PUBLISH seen, waiting for PUBREC
+    MQTT_QOS2_STATE__RECEIVED,      // PUBREC seen, waiting for PUBREL (SlowITe stalls here)
+    MQTT_QOS2_STATE__RELEASED       // PUBREL seen, waiting for PUBCOMP
+};
+
+enum mqtt_qos2_result_t
+{
+    MQTT_QOS2_RESULT__OK,
+    MQTT_QOS2_RESULT__DUPLICATE,    // New PUBLISH (DUP=0) reuses an identifier that is still in flight
+    MQTT_QOS2_RESULT__UNKNOWN,      // PUBREC/PUBREL/PUBCOMP for an identifier we are not tracking
+    MQTT_QOS2_RESULT__FULL          // No room left for another handshake
+};
+
+struct mqtt_qos2_entry_t
+{
+    uint64_t ts_ns;     // Time of the last state transition
+    uint32_t key;       // Packet identifier | originator bit
+    uint16_t prev;      // Age list, oldest transition first
+    uint16_t next;
+    uint8_t state;
+    uint8_t stalled;    // Already counted as stalled
+};
+
+// Open-addressing (linear probing) table keyed by packet identifier.
+// Identifiers are scoped by the side that sent the PUBLISH, so both
+// directions share one table. Entries are also threaded on an age list
+// so the oldest open handshake and the stalled ones are found without
+// scanning. Storage is allocated once per flow, on the first QoS 2 message.
+class MqttQos2Tracker
+{
+public:
+    MqttQos2Tracker(uint32_t max_inflight, uint64_t stall_timeout_ns);
+    ~MqttQos2Tracker();
+
+    // msg_type is one of PUBLISH (QoS 2 only), PUBREC, PUBREL, PUBCOMP
+    mqtt_qos2_result_t update(uint8_t msg_type, uint16_t msg_id, bool from_client,
+        bool dup, uint64_t now_ns);
+
+    // Marks handshakes that made no progress for stall_timeout_ns and
+    // returns how many crossed the limit since the last call
+    uint32_t check_stalled(uint64_t now_ns);
+
+    uint32_t get_inflight() const
+    { return inflight; }
+
+    uint32_t get_stalled() const
+    { return stalled; }
+
+    uint32_t get_duplicates() const
+    { return duplicates; }
+
+    int64_t get_oldest_age_ns(uint64_t now_ns) const;
+
+private:
+    static constexpr uint16_t NIL = 0xFFFF;
+
+    mqtt_qos2_entry_t* table = nullptr;
+    uint32_t mask = 0;              // Table size - 1, size is a power of two
+    uint32_t max_inflight;
+    uint64_t stall_timeout_ns;
+
+    uint32_t inflight = 0;
+    uint32_t stalled = 0;
+    uint32_t duplicates = 0;
+
+    uint16_t head = NIL;            // Oldest transition
+    uint16_t tail = NIL;            // Newest transition
+    uint16_t stall_cursor = NIL;    // First entry on the age list that is not stalled yet
+
+    bool allocate();
+    uint32_t home(uint32_t key) const;
+    uint16_t find(uint32_t key) const;
+    uint16_t insert(uint32_t key);
+    void remove(uint16_t idx);
+
+    void link_tail(uint16_t idx);
+    void unlink(uint16_t idx);
+    void relink(uint16_t from, uint16_t to);
+    void touch(uint16_t idx, uint8_t state, uint64_t now_ns);
+};
+
+#endif
@@ -0,0 +1,125 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_rate_limit.cc author Zhinoo Zobairi
+// Lock-free per-source token buckets for CONNECT rate limiting.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mqtt_rate_limit.h"
+
+#include <cmath>
+
+#define TAG_SHIFT 48
+#define TOKEN_SHIFT 32
+#define TOKEN_MASK 0xFFFF
+
+// Packet times of the threads sharing the table differ by less than this
+#define MAX_SKEW_MS 60000
+
+static inline uint64_t make_word(uint64_t tag, uint64_t tokens, uint32_t ms)
+{ return (tag << TAG_SHIFT) | (tokens << TOKEN_SHIFT) | ms; }
+
+static inline uint64_t get_tag(uint64_t w)
+{ return w >> TAG_SHIFT; }
+
+static inline uint64_t get_tokens(uint64_t w)
+{ return (w >> TOKEN_SHIFT) & TOKEN_MASK; }
+
+static inline uint32_t get_stamp(uint64_t w)
+{ return static_cast<uint32_t>(w); }
+
+MqttRateLimiter::MqttRateLimiter(unsigned buckets, double rate, uint32_t b)
+{
+    uint32_t size = 2;
+    while (size < buckets)
+        size <<= 1;
+
+    table.reset(new std::atomic<uint64_t>[size]);
+    mask = size - 1;
+    burst = b < MQTT_BUCKET_MAX_BURST ? b : MQTT_BUCKET_MAX_BURST;
+    per_ms = rate / 1000.0;
+
+    // Tag 0 with a full bucket, which any source may take
+    for (uint32_t i = 0; i < size; i++)
+        table[i].store(make_word(0, burst, 0), std::memory_order_relaxed);
+}
+
+// The bucket brought forward to now. A stamp a little ahead of now comes
+// from another thread and has earned nothing yet; one far ahead is a stamp
+// from before the wrap, long enough ago to have refilled the bucket.
+uint64_t MqttRateLimiter::refill(uint64_t word, uint32_t now_ms) const
+{
+    uint32_t stamp = get_stamp(word);
+    int32_t elapsed = static_cast<int32_t>(now_ms - stamp);
+
+    if (elapsed <= 0 && elapsed > -MAX_SKEW_MS)
+        return word;
+
+    if (elapsed < 0)
+        return make_word(get_tag(word), burst, now_ms);
+
+    uint64_t tokens = get_tokens(word);
+    uint64_t earned = static_cast<uint64_t>(elapsed * per_ms);
+
+    if (tokens + earned >= burst)
+        return make_word(get_tag(word), burst, now_ms);
+
+    // Keep the time toward the next token for the next refill; the slack
+    // stops rounding error in the division from costing a whole millisecond
+    uint32_t used = static_cast<uint32_t>(std::ceil(earned / per_ms - 1e-6));
+    if (used > static_cast<uint32_t>(elapsed))
+        used = elapsed;
+
+    return make_word(get_tag(word), tokens + earned, stamp + used);
+}
+
+bool MqttRateLimiter::allow(uint64_t hash, uint64_t now_ns)
+{
+    uint64_t tag = hash >> TAG_SHIFT;
+    uint32_t now_ms = static_cast<uint32_t>(now_ns / 1000000);
+    uint32_t base = hash & mask & ~1u;
+
+    while (true)
+    {
+        // Own bucket if either holds the tag, else the fuller of the two
+        uint32_t i = base;
+        uint64_t word = table[i].load(std::memory_order_relaxed);
+        uint64_t other = table[i + 1].load(std::memory_order_relaxed);
+
+        if (get_tag(word) != tag &&
+            (get_tag(other) == tag ||
+            get_tokens(refill(other, now_ms)) > get_tokens(refill(word, now_ms))))
+        {
+            i++;
+            word = other;
+        }
+
+        uint64_t next = get_tag(word) == tag ? refill(word, now_ms) :
+            make_word(tag, burst, now_ms);
+        bool allowed = get_tokens(next) > 0;
+
+        if (allowed)
+            next -= 1ULL << TOKEN_SHIFT;
+
+        if (table[i].compare_exchange_weak(word, next, std::memory_order_relaxed))
+            return allowed;
+    }
+}
@@ -0,0 +1,56 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_rate_limit.h author Zhinoo Zobairi
+// Lock-free per-source token buckets for CONNECT rate limiting.
+
+#ifndef MQTT_RATE_LIMIT_H
+#define MQTT_RATE_LIMIT_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#define MQTT_BUCKET_MAX_BURST 65535
+
+// Token buckets shared by the packet threads. Each bucket is one 64-bit
+// word holding a 16-bit source tag, 16 bits of whole tokens and a 32-bit
+// millisecond timestamp, so taking a token is a load and a compare-and-swap.
+// The timestamp only moves on by the time that was turned into tokens, so
+// the fraction of a token earned so far is never lost. A source hashes to
+// two adjacent buckets; a new source takes the one that is idle (refilled
+// to the burst) or else the fuller one. The timestamp wraps after about 49
+// days; a bucket idle for more than half of that counts as full.
+class MqttRateLimiter
+{
+public:
+    MqttRateLimiter(unsigned buckets, double rate, uint32_t burst);
+
+    // True when the source may CONNECT now; hash is its mqtt_distinct_hash
+    bool allow(uint64_t hash, uint64_t now_ns);
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> table;
+    uint32_t mask;
+    uint64_t burst;
+    double per_ms;                  // Tokens refilled per millisecond
+
+    uint64_t refill(uint64_t word, uint32_t now_ms) const;
+};
+
+#endif
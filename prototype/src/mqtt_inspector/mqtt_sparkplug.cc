@@ -0,0 +1,293 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_sparkplug.cc author Zhinoo Zobairi
+// Zero-copy reader for Sparkplug B (spBv1.0) protobuf payloads.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mqtt_sparkplug.h"
+
+#include <cstring>
+
+// Protobuf wire types
+#define WIRE_VARINT 0
+#define WIRE_FIXED64 1
+#define WIRE_LEN 2
+#define WIRE_FIXED32 5
+
+// Payload fields
+#define PAYLOAD_TIMESTAMP 1
+#define PAYLOAD_METRICS 2
+#define PAYLOAD_SEQ 3
+
+// Metric fields
+#define METRIC_NAME 1
+#define METRIC_ALIAS 2
+#define METRIC_DATATYPE 4
+#define METRIC_IS_NULL 7
+#define METRIC_INT_VALUE 10
+#define METRIC_LONG_VALUE 11
+#define METRIC_FLOAT_VALUE 12
+#define METRIC_DOUBLE_VALUE 13
+#define METRIC_BOOLEAN_VALUE 14
+#define METRIC_STRING_VALUE 15
+#define METRIC_BYTES_VALUE 16
+
+// Sparkplug DataTypes stored sign-extended from int_value
+#define DATATYPE_INT8 1
+#define DATATYPE_INT16 2
+#define DATATYPE_INT32 3
+
+static bool read_varint(const uint8_t* data, unsigned len, unsigned& pos, uint64_t& value)
+{
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && pos < len; shift += 7)
+    {
+        uint8_t b = data[pos++];
+        value |= uint64_t(b & 0x7f) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static uint64_t read_le(const uint8_t* data, unsigned bytes)
+{
+    uint64_t v = 0;
+    for (unsigned i = 0; i < bytes; i++)
+        v |= uint64_t(data[i]) << (8 * i);
+    return v;
+}
+
+// One field: its number and wire type, with the value as an integer or,
+// for length-delimited fields, as a span; pos moves past the field
+struct Field
+{
+    uint32_t number;
+    uint8_t wire;
+    uint64_t value;
+    const uint8_t* span;
+    uint32_t span_len;
+};
+
+static bool read_field(const uint8_t* data, unsigned len, unsigned& pos, Field& f)
+{
+    uint64_t key;
+    if (!read_varint(data, len, pos, key) || (key >> 3) == 0 || (key >> 3) > UINT32_MAX)
+        return false;
+
+    f.number = key >> 3;
+    f.wire = key & 7;
+
+    switch (f.wire)
+    {
+    case WIRE_VARINT:
+        return read_varint(data, len, pos, f.value);
+
+    case WIRE_FIXED64:
+        if (len - pos < 8)
+            return false;
+        f.value = read_le(data + pos, 8);
+        pos += 8;
+        return true;
+
+    case WIRE_FIXED32:
+        if (len - pos < 4)
+            return false;
+        f.value = read_le(data + pos, 4);
+        pos += 4;
+        return true;
+
+    case WIRE_LEN:
+        if (!read_varint(data, len, pos, f.value) || f.value > len - pos)
+            return false;
+        f.span = data + pos;
+        f.span_len = f.value;
+        pos += f.value;
+        return true;
+    }
+
+    // Groups are deprecated and not used by Sparkplug
+    return false;
+}
+
+//-------------------------------------------------------------------------
+// metric
+//-------------------------------------------------------------------------
+
+int64_t MqttSparkplugMetric::as_int() const
+{
+    if (value_type == MQTT_SPARKPLUG_VALUE__DOUBLE)
+    {
+        // Saturate, NaN reads as 0
+        if (double_value >= 9.2e18)
+            return INT64_MAX;
+        if (double_value <= -9.2e18)
+            return INT64_MIN;
+        return double_value == double_value ? (int64_t)double_value : 0;
+    }
+
+    switch (datatype)
+    {
+    case DATATYPE_INT8:
+        return (int8_t)int_value;
+    case DATATYPE_INT16:
+        return (int16_t)int_value;
+    case DATATYPE_INT32:
+        return (int32_t)int_value;
+    }
+    return (int64_t)int_value;
+}
+
+//-------------------------------------------------------------------------
+// reader
+//-------------------------------------------------------------------------
+
+bool MqttSparkplugReader::is_sparkplug_topic(const uint8_t* topic, unsigned len)
+{
+    return len > MQTT_SPARKPLUG_PREFIX_LEN &&
+        !memcmp(topic, MQTT_SPARKPLUG_PREFIX, MQTT_SPARKPLUG_PREFIX_LEN);
+}
+
+bool MqttSparkplugReader::open(const uint8_t* d, unsigned l)
+{
+    data = d;
+    len = l;
+    timestamp = seq = 0;
+    metric_count = 0;
+
+    unsigned pos = 0;
+    Field f;
+
+    while (pos < len)
+    {
+        if (!read_field(data, len, pos, f))
+            return false;
+
+        if (f.number == PAYLOAD_METRICS && f.wire == WIRE_LEN)
+            metric_count++;
+        else if (f.number == PAYLOAD_TIMESTAMP && f.wire == WIRE_VARINT)
+            timestamp = f.value;
+        else if (f.number == PAYLOAD_SEQ && f.wire == WIRE_VARINT)
+            seq = f.value;
+    }
+    return true;
+}
+
+void MqttSparkplugReader::attach(const uint8_t* d, unsigned l)
+{
+    data = d;
+    len = l;
+}
+
+bool MqttSparkplugReader::next(unsigned& pos, MqttSparkplugMetric& m) const
+{
+    Field f;
+
+    // Framing was checked by open()
+    do
+    {
+        if (pos >= len || !read_field(data, len, pos, f))
+            return false;
+    }
+    while (f.number != PAYLOAD_METRICS || f.wire != WIRE_LEN);
+
+    memset(&m, 0, sizeof(m));
+
+    const uint8_t* metric = f.span;
+    unsigned metric_len = f.span_len;
+    unsigned mpos = 0;
+
+    while (mpos < metric_len)
+    {
+        if (!read_field(metric, metric_len, mpos, f))
+            return false;
+
+        switch (f.number)
+        {
+        case METRIC_NAME:
+            if (f.wire == WIRE_LEN)
+            {
+                m.name = f.span;
+                m.name_len = f.span_len;
+            }
+            break;
+
+        case METRIC_ALIAS:
+            if (f.wire != WIRE_VARINT)
+                break;
+            m.alias = f.value;
+            m.has_alias = 1;
+            break;
+
+        case METRIC_DATATYPE:
+            if (f.wire != WIRE_VARINT)
+                break;
+            m.datatype = f.value;
+            break;
+
+        case METRIC_IS_NULL:
+            if (f.wire != WIRE_VARINT)
+                break;
+            m.is_null = f.value != 0;
+            break;
+
+        case METRIC_INT_VALUE:
+        case METRIC_LONG_VALUE:
+        case METRIC_BOOLEAN_VALUE:
+            if (f.wire != WIRE_VARINT)
+                break;
+            m.value_type = MQTT_SPARKPLUG_VALUE__INT;
+            m.int_value = f.value;
+            break;
+
+        case METRIC_FLOAT_VALUE:
+            if (f.wire == WIRE_FIXED32)
+            {
+                uint32_t bits = f.value;
+                float v;
+                memcpy(&v, &bits, sizeof(v));
+                m.value_type = MQTT_SPARKPLUG_VALUE__DOUBLE;
+                m.double_value = v;
+            }
+            break;
+
+        case METRIC_DOUBLE_VALUE:
+            if (f.wire == WIRE_FIXED64)
+            {
+                memcpy(&m.double_value, &f.value, sizeof(m.double_value));
+                m.value_type = MQTT_SPARKPLUG_VALUE__DOUBLE;
+            }
+            break;
+
+        case METRIC_STRING_VALUE:
+        case METRIC_BYTES_VALUE:
+            if (f.wire == WIRE_LEN)
+            {
+                m.value_type = MQTT_SPARKPLUG_VALUE__STRING;
+                m.str = f.span;
+                m.str_len = f.span_len;
+            }
+            break;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,86 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_sparkplug.h author Zhinoo Zobairi
+// Zero-copy reader for Sparkplug B (spBv1.0) protobuf payloads.
+
+#ifndef MQTT_SPARKPLUG_H
+#define MQTT_SPARKPLUG_H
+
+#include <cstdint>
+
+#define MQTT_SPARKPLUG_PREFIX "spBv1.0/"
+#define MQTT_SPARKPLUG_PREFIX_LEN 8
+
+enum mqtt_sparkplug_value_t : uint8_t
+{
+    MQTT_SPARKPLUG_VALUE__NONE,     // No value, or one we do not decode (dataset, template)
+    MQTT_SPARKPLUG_VALUE__INT,      // int_value, long_value and boolean_value
+    MQTT_SPARKPLUG_VALUE__DOUBLE,   // float_value and double_value
+    MQTT_SPARKPLUG_VALUE__STRING,   // string_value and bytes_value
+};
+
+// One Payload.Metric; the pointers refer to the packet data
+struct MqttSparkplugMetric
+{
+    const uint8_t* name;            // Null when only the alias is sent
+    uint32_t name_len;
+    uint64_t alias;
+    uint32_t datatype;              // Sparkplug DataType, 0 = unknown
+    uint8_t has_alias;
+    uint8_t is_null;
+    mqtt_sparkplug_value_t value_type;
+    uint64_t int_value;             // Raw, see as_int()
+    double double_value;
+    const uint8_t* str;
+    uint32_t str_len;
+
+    // Signed value as the datatype defines it, doubles truncated
+    int64_t as_int() const;
+};
+
+// A Payload is walked in two levels only: its own fields and the fields
+// of each Metric. Nested messages inside a metric (metadata, properties,
+// datasets, templates) are stepped over by their length, so the nesting
+// depth is fixed and nothing is allocated per metric.
+class MqttSparkplugReader
+{
+public:
+    static bool is_sparkplug_topic(const uint8_t* topic, unsigned len);
+
+    // Checks the framing of every top-level field and reads timestamp and
+    // seq; false when the payload is not a well-formed Sparkplug payload
+    bool open(const uint8_t* data, unsigned len);
+
+    // For a payload open() already accepted, without walking it again
+    void attach(const uint8_t* data, unsigned len);
+
+    // Metric starting the search at pos (0 = first), pos moves past it;
+    // false when there are no more or the metric is malformed
+    bool next(unsigned& pos, MqttSparkplugMetric&) const;
+
+    uint64_t timestamp = 0;
+    uint64_t seq = 0;
+    unsigned metric_count = 0;
+
+private:
+    const uint8_t* data = nullptr;
+    unsigned len = 0;
+};
+
+#endif
@@ -0,0 +1,176 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_state.cc author Zhinoo Zobairi
+// Table-driven MQTT connection state machine (MQTT 3.1.1 section 3, MQTT 5.0 section 4).
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mqtt_state.h"
+
+#include <cstring>
+
+uint8_t MqttProtoState::table[MQTT_CONN_STATE__MAX][MQTT_SM_CONNACK_REFUSED + 1][2];
+
+// Which side may send each packet type
+#define FROM_CLIENT 0x01
+#define FROM_SERVER 0x02
+
+static const uint8_t senders[MQTT_SM_CONNACK_REFUSED + 1] =
+{
+    0,                              // 0  reserved, reported as MQTT_RESERVED_TYPE
+    FROM_CLIENT,                    // 1  CONNECT
+    FROM_SERVER,                    // 2  CONNACK
+    FROM_CLIENT | FROM_SERVER,      // 3  PUBLISH
+    FROM_CLIENT | FROM_SERVER,      // 4  PUBACK
+    FROM_CLIENT | FROM_SERVER,      // 5  PUBREC
+    FROM_CLIENT | FROM_SERVER,      // 6  PUBREL
+    FROM_CLIENT | FROM_SERVER,      // 7  PUBCOMP
+    FROM_CLIENT,                    // 8  SUBSCRIBE
+    FROM_SERVER,                    // 9  SUBACK
+    FROM_CLIENT,                    // 10 UNSUBSCRIBE
+    FROM_SERVER,                    // 11 UNSUBACK
+    FROM_CLIENT,                    // 12 PINGREQ
+    FROM_SERVER,                    // 13 PINGRESP
+    FROM_CLIENT | FROM_SERVER,      // 14 DISCONNECT (server side since MQTT 5)
+    FROM_CLIENT | FROM_SERVER,      // 15 AUTH (MQTT 5)
+    FROM_SERVER,                    // 16 CONNACK with a non-zero return code
+};
+
+static inline uint8_t entry(uint8_t next, mqtt_sm_violation_t violation)
+{ return next | (violation << 4); }
+
+static uint8_t transition(uint8_t state, uint8_t type, bool from_client)
+{
+    if (type == 0)
+        return entry(state, MQTT_SM__OK);
+
+    if (!(senders[type] & (from_client ? FROM_CLIENT : FROM_SERVER)))
+        return entry(state, MQTT_SM__WRONG_DIRECTION);
+
+    bool connect = (type == 1);
+    bool connack = (type == 2 || type == MQTT_SM_CONNACK_REFUSED);
+    bool disconnect = (type == 14);
+    uint8_t after_connack = (type == MQTT_SM_CONNACK_REFUSED) ?
+        MQTT_CONN_STATE__REFUSED : MQTT_CONN_STATE__CONNECTED;
+
+    switch (state)
+    {
+    case MQTT_CONN_STATE__IDLE:
+        if (connect)
+            return entry(MQTT_CONN_STATE__CONNECTING, MQTT_SM__OK);
+        return entry(state, MQTT_SM__NOT_CONNECTED);
+
+    case MQTT_CONN_STATE__CONNECTING:
+        if (connect)
+            return entry(state, MQTT_SM__DUP_CONNECT);
+        if (connack)
+            return entry(after_connack, MQTT_SM__OK);
+        if (disconnect)
+            return entry(MQTT_CONN_STATE__CLOSED, MQTT_SM__OK);
+        // Clients may pipeline right after CONNECT, the server has to answer
+        // with CONNACK first (AUTH is MQTT 5 enhanced authentication)
+        if (from_client || type == 15)
+            return entry(state, MQTT_SM__OK);
+        return entry(state, MQTT_SM__NOT_CONNECTED);
+
+    case MQTT_CONN_STATE__CONNECTED:
+        if (connect || connack)
+            return entry(state, MQTT_SM__DUP_CONNECT);
+        if (disconnect)
+            return entry(MQTT_CONN_STATE__CLOSED, MQTT_SM__OK);
+        return entry(state, MQTT_SM__OK);
+
+    case MQTT_CONN_STATE__REFUSED:
+        if (disconnect)
+            return entry(MQTT_CONN_STATE__CLOSED, MQTT_SM__OK);
+        return entry(state, MQTT_SM__AFTER_REFUSED);
+
+    case MQTT_CONN_STATE__CLOSED:
+        // Server packets may already have been in flight when the client left
+        if (from_client)
+            return entry(state, MQTT_SM__AFTER_DISCONNECT);
+        return entry(state, MQTT_SM__OK);
+
+    case MQTT_CONN_STATE__MIDSTREAM:
+        if (connect)
+            return entry(MQTT_CONN_STATE__CONNECTING, MQTT_SM__OK);
+        if (connack)
+            return entry(after_connack, MQTT_SM__OK);
+        if (disconnect)
+            return entry(MQTT_CONN_STATE__CLOSED, MQTT_SM__OK);
+        return entry(state, MQTT_SM__OK);
+    }
+
+    return entry(state, MQTT_SM__OK);
+}
+
+void MqttProtoState::init_table()
+{
+    for (uint8_t s = 0; s < MQTT_CONN_STATE__MAX; s++)
+    {
+        for (uint8_t t = 0; t <= MQTT_SM_CONNACK_REFUSED; t++)
+        {
+            table[s][t][0] = transition(s, t, true);
+            table[s][t][1] = transition(s, t, false);
+        }
+    }
+}
+
+void MqttProtoState::init(bool midstream)
+{
+    state = midstream ? MQTT_CONN_STATE__MIDSTREAM : MQTT_CONN_STATE__IDLE;
+    pending_next = 0;
+    memset(pending, 0, sizeof(pending));
+}
+
+mqtt_sm_violation_t MqttProtoState::update(uint8_t msg_type, bool connack_refused, bool from_client)
+{
+    uint8_t type = (msg_type == 2 && connack_refused) ? MQTT_SM_CONNACK_REFUSED : (msg_type & 0x0F);
+    uint8_t e = table[state][type][from_client ? 0 : 1];
+    mqtt_sm_violation_t violation = static_cast<mqtt_sm_violation_t>(e >> 4);
+
+    if (violation == MQTT_SM__OK)
+        state = e & 0x0F;
+
+    return violation;
+}
+
+void MqttProtoState::on_subscribe(uint16_t msg_id, uint16_t count)
+{
+    // Oldest request is overwritten; a SUBACK we no longer remember is not checked
+    pending[pending_next].msg_id = msg_id;
+    pending[pending_next].count = count;
+    pending_next = (pending_next + 1) % MQTT_SM_PENDING_SUBS;
+}
+
+bool MqttProtoState::on_suback(uint16_t msg_id, uint16_t count)
+{
+    for (auto& sub : pending)
+    {
+        if (sub.count && sub.msg_id == msg_id)
+        {
+            bool match = (sub.count == count);
+            sub.count = 0;
+            return match;
+        }
+    }
+    return true;
+}
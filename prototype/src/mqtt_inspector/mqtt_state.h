@@ -0,0 +1,94 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_state.h author Zhinoo Zobairi
+// Per-connection MQTT protocol state machine.
+
+#ifndef MQTT_STATE_H
+#define MQTT_STATE_H
+
+#include <cstdint>
+
+// Where the connection is in the CONNECT/CONNACK/DISCONNECT life cycle
+enum mqtt_conn_state_t : uint8_t
+{
+    MQTT_CONN_STATE__IDLE,          // Nothing seen yet, only CONNECT is legal
+    MQTT_CONN_STATE__CONNECTING,    // CONNECT seen, waiting for CONNACK
+    MQTT_CONN_STATE__CONNECTED,     // CONNACK accepted the session
+    MQTT_CONN_STATE__REFUSED,       // CONNACK refused, only DISCONNECT may follow
+    MQTT_CONN_STATE__CLOSED,        // DISCONNECT seen
+    MQTT_CONN_STATE__MIDSTREAM,     // Picked up mid-session, history unknown
+    MQTT_CONN_STATE__MAX
+};
+
+// What was wrong with the transition, if anything
+enum mqtt_sm_violation_t : uint8_t
+{
+    MQTT_SM__OK,
+    MQTT_SM__NOT_CONNECTED,         // Packet before CONNECT, or server talking before CONNACK
+    MQTT_SM__DUP_CONNECT,           // Second CONNECT or CONNACK on the connection
+    MQTT_SM__AFTER_REFUSED,         // Anything but DISCONNECT after a refused CONNACK
+    MQTT_SM__WRONG_DIRECTION,       // Packet type the sender is never allowed to send
+    MQTT_SM__AFTER_DISCONNECT,      // Traffic after DISCONNECT
+    MQTT_SM__MAX
+};
+
+// Pseudo packet type for a CONNACK with a non-zero return code
+#define MQTT_SM_CONNACK_REFUSED 16
+
+struct mqtt_pending_sub_t
+{
+    uint16_t msg_id;
+    uint16_t count;                 // Topic filters requested, 0 = slot unused
+};
+
+#define MQTT_SM_PENDING_SUBS 4
+
+// 18 bytes per flow. Transitions come from a static table indexed by
+// state, packet type and direction; SUBSCRIBE requests are remembered in
+// a tiny ring so the matching SUBACK can be checked for the right count.
+class MqttProtoState
+{
+public:
+    static void init_table();
+
+    void init(bool midstream);
+
+    // Applies one PDU and returns the violation it caused, the state is
+    // left unchanged on a violation
+    mqtt_sm_violation_t update(uint8_t msg_type, bool connack_refused, bool from_client);
+
+    void on_subscribe(uint16_t msg_id, uint16_t count);
+
+    // False when the SUBACK carries a different number of return codes
+    // than its SUBSCRIBE asked for
+    bool on_suback(uint16_t msg_id, uint16_t count);
+
+    uint8_t get_state() const
+    { return state; }
+
+private:
+    // Entry: next state in the low nibble, violation in the high nibble
+    static uint8_t table[MQTT_CONN_STATE__MAX][MQTT_SM_CONNACK_REFUSED + 1][2];
+
+    uint8_t state;
+    uint8_t pending_next;
+    mqtt_pending_sub_t pending[MQTT_SM_PENDING_SUBS];
+};
+
+#endif
@@ -0,0 +1,152 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_timer.cc author Zhinoo Zobairi
+// Hierarchical timing wheel implementation.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mqtt_timer.h"
+
+static inline void link_timer(MqttTimer*& head, MqttTimer* t)
+{
+    t->next = head;
+    t->pprev = &head;
+    if (head)
+        head->pprev = &t->next;
+    head = t;
+}
+
+static inline void unlink_timer(MqttTimer* t)
+{
+    *t->pprev = t->next;
+    if (t->next)
+        t->next->pprev = t->pprev;
+    t->next = nullptr;
+    t->pprev = nullptr;
+}
+
+MqttTimerWheel::MqttTimerWheel(uint64_t tick) : tick_ns(tick ? tick : 1)
+{ }
+
+MqttTimerWheel::~MqttTimerWheel()
+{
+    // Flows can outlive the wheel at thread shutdown; leave their timers
+    // disarmed so the flow destructor does not touch freed slots
+    for (auto& level : slots)
+    {
+        for (auto& head : level)
+        {
+            while (MqttTimer* t = head)
+                unlink_timer(t);
+        }
+    }
+}
+
+void MqttTimerWheel::insert(MqttTimer* t)
+{
+    // Already due: fire on the next tick
+    if (t->expires <= now_tick)
+        t->expires = now_tick + 1;
+
+    // Deadlines past the top level are clamped, they cascade down from there
+    const uint64_t span = 1ULL << (SLOT_BITS * LEVELS);
+    if (t->expires - now_tick >= span)
+        t->expires = now_tick + span - 1;
+
+    uint64_t delta = t->expires - now_tick;
+    unsigned level = 0;
+    while (level < LEVELS - 1 && delta >= (1ULL << (SLOT_BITS * (level + 1))))
+        level++;
+
+    unsigned idx = (t->expires >> (SLOT_BITS * level)) & SLOT_MASK;
+    link_timer(slots[level][idx], t);
+}
+
+void MqttTimerWheel::schedule(MqttTimer* t, uint64_t expires_ns)
+{
+    if (t->is_armed())
+        unlink_timer(t);
+    else
+        armed++;
+
+    t->expires = (expires_ns + tick_ns - 1) / tick_ns;
+    insert(t);
+}
+
+void MqttTimerWheel::cancel(MqttTimer* t)
+{
+    if (!t->is_armed())
+        return;
+
+    unlink_timer(t);
+    armed--;
+}
+
+void MqttTimerWheel::cascade(unsigned level)
+{
+    MqttTimer*& head = slots[level][(now_tick >> (SLOT_BITS * level)) & SLOT_MASK];
+
+    // Every timer here is now within reach of a lower level
+    while (MqttTimer* t = head)
+    {
+        unlink_timer(t);
+        insert(t);
+    }
+}
+
+void MqttTimerWheel::advance(uint64_t now_ns, ExpireFunc fire)
+{
+    uint64_t target = now_ns / tick_ns;
+
+    if (!started)
+    {
+        now_tick = target;
+        started = true;
+        return;
+    }
+
+    while (now_tick < target)
+    {
+        // Nothing armed, no reason to walk the empty ticks
+        if (armed == 0)
+        {
+            now_tick = target;
+            break;
+        }
+
+        now_tick++;
+
+        for (unsigned level = 1; level < LEVELS; level++)
+        {
+            if (now_tick & ((1ULL << (SLOT_BITS * level)) - 1))
+                break;
+            cascade(level);
+        }
+
+        MqttTimer*& head = slots[0][now_tick & SLOT_MASK];
+        while (MqttTimer* t = head)
+        {
+            unlink_timer(t);
+            armed--;
+            fire(t, now_ns);
+        }
+    }
+}
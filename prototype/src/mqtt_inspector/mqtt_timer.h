@@ -0,0 +1,80 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_timer.h author Zhinoo Zobairi
+// Hierarchical timing wheel used for per-flow keep-alive deadlines.
+
+#ifndef MQTT_TIMER_H
+#define MQTT_TIMER_H
+
+#include <cstdint>
+
+class MqttFlowData;
+
+// Intrusive timer, embedded in the flow so arming it never allocates
+struct MqttTimer
+{
+    MqttTimer* next = nullptr;
+    MqttTimer** pprev = nullptr;    // Slot head or previous timer's next, null when idle
+    uint64_t expires = 0;           // Absolute deadline in wheel ticks
+    MqttFlowData* flow = nullptr;
+
+    bool is_armed() const
+    { return pprev != nullptr; }
+};
+
+// Four levels of 64 slots. Level 0 has one tick per slot, every level
+// above covers 64 times the span of the one below, and timers move down a
+// level when the lower level wraps. Scheduling and cancelling are O(1).
+// The wheel is driven by packet time, so it works the same for live
+// traffic and pcap replay.
+class MqttTimerWheel
+{
+public:
+    typedef void (*ExpireFunc)(MqttTimer*, uint64_t now_ns);
+
+    MqttTimerWheel(uint64_t tick_ns);
+    ~MqttTimerWheel();
+
+    // (Re)arms the timer, cancelling any earlier deadline
+    void schedule(MqttTimer*, uint64_t expires_ns);
+    void cancel(MqttTimer*);
+
+    // Fires every timer whose deadline is at or before now_ns
+    void advance(uint64_t now_ns, ExpireFunc);
+
+    uint32_t get_armed() const
+    { return armed; }
+
+private:
+    static constexpr unsigned LEVELS = 4;
+    static constexpr unsigned SLOT_BITS = 6;
+    static constexpr unsigned SLOTS = 1 << SLOT_BITS;
+    static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+
+    MqttTimer* slots[LEVELS][SLOTS] = { };
+    uint64_t tick_ns;
+    uint64_t now_tick = 0;
+    bool started = false;
+    uint32_t armed = 0;
+
+    void insert(MqttTimer*);
+    void cascade(unsigned level);
+};
+
+#endif
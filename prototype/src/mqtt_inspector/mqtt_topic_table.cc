@@ -0,0 +1,254 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_topic_table.cc author Zhinoo Zobairi
+// Per-thread interning of PUBLISH topics into dense ids with statistics.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mqtt_topic_table.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <vector>
+
+#include "log/messages.h"
+#include "main/thread.h"
+
+#include "mqtt.h"
+
+using namespace snort;
+
+// Topics listed per thread by the dump command
+#define MQTT_TOPIC_DUMP_MAX 50
+
+THREAD_LOCAL MqttTopicTable* mqtt_topic_table = nullptr;
+
+static uint64_t topic_hash(const uint8_t* topic, unsigned len)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned i = 0; i < len; i++)
+    {
+        h ^= topic[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+MqttTopicTable::MqttTopicTable(uint32_t memcap)
+{
+    // Each id costs its entry, its arena slot and two index slots
+    size_t per_id = sizeof(Entry) + MQTT_TOPIC_MAX_LEN + 2 * sizeof(uint32_t);
+    capacity = memcap / per_id;
+
+    if (!capacity)
+        return;
+
+    uint32_t size = 2;
+    while (size < 2 * capacity)
+        size <<= 1;
+
+    entries = new Entry[capacity + 1]();
+    arena = new uint8_t[(size_t)capacity * MQTT_TOPIC_MAX_LEN];
+    slots = new uint32_t[size]();
+    slot_mask = size - 1;
+}
+
+MqttTopicTable::~MqttTopicTable()
+{
+    delete[] entries;
+    delete[] arena;
+    delete[] slots;
+}
+
+const uint8_t* MqttTopicTable::get_topic(uint32_t id, unsigned& len) const
+{
+    len = entries[id].len;
+    return arena + (size_t)(id - 1) * MQTT_TOPIC_MAX_LEN;
+}
+
+void MqttTopicTable::unlink(uint32_t id)
+{
+    Entry& e = entries[id];
+
+    if (e.prev)
+        entries[e.prev].next = e.next;
+    else
+        head = e.next;
+
+    if (e.next)
+        entries[e.next].prev = e.prev;
+    else
+        tail = e.prev;
+
+    e.prev = e.next = 0;
+}
+
+void MqttTopicTable::push_front(uint32_t id)
+{
+    Entry& e = entries[id];
+
+    e.prev = 0;
+    e.next = head;
+
+    if (head)
+        entries[head].prev = id;
+    else
+        tail = id;
+
+    head = id;
+}
+
+uint32_t MqttTopicTable::find_slot(uint32_t id) const
+{
+    uint32_t i = entries[id].hash & slot_mask;
+
+    while (slots[i] != id)
+        i = (i + 1) & slot_mask;
+
+    return i;
+}
+
+// Backward shift deletion keeps every probe chain unbroken without tombstones
+void MqttTopicTable::remove_slot(uint32_t id)
+{
+    uint32_t i = find_slot(id);
+    uint32_t j = i;
+
+    while (true)
+    {
+        j = (j + 1) & slot_mask;
+        if (!slots[j])
+            break;
+
+        // An id whose home lies cyclically in (i, j] stays where it is
+        uint32_t home = entries[slots[j]].hash & slot_mask;
+        bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+
+        if (!stays)
+        {
+            slots[i] = slots[j];
+            i = j;
+        }
+    }
+    slots[i] = 0;
+}
+
+uint32_t MqttTopicTable::intern(const uint8_t* topic, unsigned len, bool& fresh)
+{
+    fresh = false;
+
+    if (!capacity)
+        return 0;
+
+    uint64_t h = topic_hash(topic, len);
+    uint32_t i = h & slot_mask;
+    unsigned kept = len < MQTT_TOPIC_MAX_LEN ? len : MQTT_TOPIC_MAX_LEN;
+
+    while (uint32_t id = slots[i])
+    {
+        const Entry& e = entries[id];
+        if (e.hash == h && e.len == len &&
+            !memcmp(arena + (size_t)(id - 1) * MQTT_TOPIC_MAX_LEN, topic, kept))
+        {
+            if (head != id)
+            {
+                unlink(id);
+                push_front(id);
+            }
+            return id;
+        }
+        i = (i + 1) & slot_mask;
+    }
+
+    uint32_t id;
+
+    if (count < capacity)
+        id = ++count;
+    else
+    {
+        id = tail;
+        remove_slot(id);
+        unlink(id);
+        mqtt_stats.topic_evictions++;
+
+        // The freed slot may be the one found empty above
+        i = h & slot_mask;
+        while (slots[i])
+            i = (i + 1) & slot_mask;
+    }
+
+    Entry& e = entries[id];
+    e.hash = h;
+    e.len = len;
+    memset(&e.stats, 0, sizeof(e.stats));
+    memcpy(arena + (size_t)(id - 1) * MQTT_TOPIC_MAX_LEN, topic, kept);
+
+    slots[i] = id;
+    push_front(id);
+    fresh = true;
+    mqtt_stats.topics_interned++;
+
+    return id;
+}
+
+//-------------------------------------------------------------------------
+// dump command
+//-------------------------------------------------------------------------
+
+bool MqttTopicDumpCommand::execute(Analyzer&, void**)
+{
+    const MqttTopicTable* table = mqtt_topic_table;
+
+    if (!table)
+    {
+        LogMessage("mqtt topics, thread %u: no topic table\n", get_instance_id());
+        return true;
+    }
+
+    std::vector<uint32_t> ids;
+    ids.reserve(table->size());
+
+    for (uint32_t id = table->first(); id; id = table->next(id))
+        ids.push_back(id);
+
+    size_t shown = std::min<size_t>(ids.size(), MQTT_TOPIC_DUMP_MAX);
+    std::partial_sort(ids.begin(), ids.begin() + shown, ids.end(),
+        [table](uint32_t a, uint32_t b)
+        { return table->get_stats(a).messages > table->get_stats(b).messages; });
+
+    LogMessage("mqtt topics, thread %u: %u of %u entries in use\n",
+        get_instance_id(), table->size(), table->get_capacity());
+
+    for (size_t i = 0; i < shown; i++)
+    {
+        unsigned len;
+        const uint8_t* topic = table->get_topic(ids[i], len);
+        const MqttTopicStats& s = table->get_stats(ids[i]);
+
+        LogMessage("  %u %.*s%s: messages %" PRIu64 ", bytes %" PRIu64
+            ", size %.1f+-%.1f, interval %.0f+-%.0f us\n",
+            ids[i], (int)std::min(len, (unsigned)MQTT_TOPIC_MAX_LEN), (const char*)topic,
+            len > MQTT_TOPIC_MAX_LEN ? "..." : "", s.messages, s.bytes,
+            s.size.mean, s.size.stddev(), s.interval.mean, s.interval.stddev());
+    }
+    return true;
+}
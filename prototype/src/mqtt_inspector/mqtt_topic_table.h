@@ -0,0 +1,151 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_topic_table.h author Zhinoo Zobairi
+// Per-thread interning of PUBLISH topics into dense ids with statistics.
+
+#ifndef MQTT_TOPIC_TABLE_H
+#define MQTT_TOPIC_TABLE_H
+
+#include <cmath>
+#include <cstdint>
+
+#include "main/analyzer_command.h"
+
+// Bytes of a topic kept; longer topics are told apart by their prefix, their
+// length and a 64-bit hash of the whole topic
+#define MQTT_TOPIC_MAX_LEN 128
+
+// Running mean and variance without a sum of squares (Welford)
+struct MqttWelford
+{
+    uint64_t n;
+    double mean;
+    double m2;                      // Sum of squared differences from the mean
+
+    void add(double x)
+    {
+        n++;
+        double diff = x - mean;
+        mean += diff / n;
+        m2 += diff * (x - mean);
+    }
+
+    double stddev() const
+    { return n > 1 ? std::sqrt(m2 / (n - 1)) : 0.0; }
+
+    // Distance of x from the mean in standard deviations, which are taken
+    // to be at least floor so that a perfectly steady topic still compares
+    double zscore(double x, double floor) const
+    {
+        double sd = stddev();
+        return std::fabs(x - mean) / (sd > floor ? sd : floor);
+    }
+};
+
+struct MqttTopicStats
+{
+    uint64_t messages;
+    uint64_t bytes;                 // Payload bytes
+    uint64_t first_seen_ns;         // Since the id was given to this topic
+    uint64_t last_seen_ns;
+
+    // Baselines of the payload length in bytes and the time between two
+    // PUBLISH to the topic in microseconds
+    MqttWelford size;
+    MqttWelford interval;
+};
+
+// Ids run from 1 to the capacity the memcap allows, so per-topic state can
+// live in plain arrays indexed by id. When the table is full the least
+// recently used topic is evicted and its id given to the new topic; the
+// caller learns this from fresh and must reset whatever it keeps per id.
+//
+// All memory is allocated up front: an entry array, an arena with a fixed
+// MQTT_TOPIC_MAX_LEN slot per id and an open-addressed index of ids. A
+// longer topic keeps its first MQTT_TOPIC_MAX_LEN bytes, so it still gets
+// baselines of its own.
+class MqttTopicTable
+{
+public:
+    MqttTopicTable(uint32_t memcap);
+    ~MqttTopicTable();
+
+    // 0 when the memcap allows no entries
+    uint32_t intern(const uint8_t* topic, unsigned len, bool& fresh);
+
+    MqttTopicStats& get_stats(uint32_t id)
+    { return entries[id].stats; }
+
+    const MqttTopicStats& get_stats(uint32_t id) const
+    { return entries[id].stats; }
+
+    // len is the full topic length; at most MQTT_TOPIC_MAX_LEN bytes are kept
+    const uint8_t* get_topic(uint32_t id, unsigned& len) const;
+
+    unsigned size() const
+    { return count; }
+
+    unsigned get_capacity() const
+    { return capacity; }
+
+    // Ids from most to least recently used, 0 = end
+    uint32_t first() const
+    { return head; }
+
+    uint32_t next(uint32_t id) const
+    { return entries[id].next; }
+
+private:
+    struct Entry
+    {
+        uint64_t hash;              // Of the whole topic
+        uint32_t len;
+        uint32_t prev;              // LRU list, 0 = none
+        uint32_t next;
+        MqttTopicStats stats;
+    };
+
+    Entry* entries = nullptr;       // capacity + 1, entry 0 unused
+    uint8_t* arena = nullptr;       // Topic of id at (id - 1) * MQTT_TOPIC_MAX_LEN
+    uint32_t* slots = nullptr;      // Ids, 0 = empty, linear probing
+    uint32_t slot_mask = 0;
+    uint32_t capacity = 0;
+    uint32_t count = 0;
+    uint32_t head = 0;
+    uint32_t tail = 0;
+
+    uint32_t find_slot(uint32_t id) const;
+    void remove_slot(uint32_t id);
+    void unlink(uint32_t id);
+    void push_front(uint32_t id);
+};
+
+// Logs each packet thread's busiest topics
+class MqttTopicDumpCommand : public snort::AnalyzerCommand
+{
+public:
+    bool execute(snort::Analyzer&, void**) override;
+
+    const char* stringify() override
+    { return "MQTT_TOPIC_DUMP"; }
+};
+
+extern THREAD_LOCAL MqttTopicTable* mqtt_topic_table;
+
+#endif
@@ -0,0 +1,280 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_topic_trie.cc author Zhinoo Zobairi
+// Level trie matching a topic against many MQTT topic filters at once.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mqtt_topic_trie.h"
+
+#include <cstring>
+
+#define ROOT 0
+
+static uint32_t edge_hash(uint32_t parent, const uint8_t* level, unsigned len)
+{
+    // FNV-1a over the parent node and the level bytes
+    uint32_t h = 2166136261u ^ parent;
+    h *= 16777619u;
+    for (unsigned i = 0; i < len; i++)
+    {
+        h ^= level[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+MqttTopicTrie::MqttTopicTrie()
+{
+    new_node();
+}
+
+uint32_t MqttTopicTrie::new_node()
+{
+    nodes.push_back({ 0, 0, 0, 0, 0 });
+    build_ids.emplace_back();
+    build_hash_ids.emplace_back();
+    return nodes.size() - 1;
+}
+
+bool MqttTopicTrie::valid_filter(const char* filter, unsigned len)
+{
+    if (len == 0)
+        return false;
+
+    for (unsigned i = 0; i < len; i++)
+    {
+        bool level_start = (i == 0 || filter[i - 1] == '/');
+        bool level_end = (i + 1 == len || filter[i + 1] == '/');
+
+        if (filter[i] == '+' && !(level_start && level_end))
+            return false;
+
+        if (filter[i] == '#' && !(level_start && i + 1 == len))
+            return false;
+    }
+    return true;
+}
+
+unsigned MqttTopicTrie::add(const char* filter, unsigned len)
+{
+    auto known = build_filters.find(std::string(filter, len));
+    if (known != build_filters.end())
+        return known->second;
+
+    unsigned id = filter_count++;
+    build_filters.emplace(std::string(filter, len), id);
+
+    uint32_t node = ROOT;
+    unsigned pos = 0;
+
+    while (true)
+    {
+        const char* end = static_cast<const char*>(memchr(filter + pos, '/', len - pos));
+        unsigned level_len = end ? end - (filter + pos) : len - pos;
+
+        if (level_len == 1 && filter[pos] == '#')
+        {
+            build_hash_ids[node].push_back(id);
+            break;
+        }
+
+        if (level_len == 1 && filter[pos] == '+')
+        {
+            if (!nodes[node].plus)
+            {
+                uint32_t n = new_node();
+                nodes[node].plus = n;
+            }
+            node = nodes[node].plus;
+        }
+        else
+        {
+            auto key = std::make_pair(node, std::string(filter + pos, level_len));
+            auto it = build_edges.find(key);
+            if (it == build_edges.end())
+            {
+                uint32_t n = new_node();
+                it = build_edges.emplace(key, n).first;
+            }
+            node = it->second;
+        }
+
+        if (!end)
+        {
+            build_ids[node].push_back(id);
+            break;
+        }
+        pos += level_len + 1;
+    }
+
+    return id;
+}
+
+void MqttTopicTrie::compile()
+{
+    for (uint32_t n = 0; n < nodes.size(); n++)
+    {
+        nodes[n].ids = id_pool.size();
+        nodes[n].id_count = build_ids[n].size();
+        id_pool.insert(id_pool.end(), build_ids[n].begin(), build_ids[n].end());
+
+        nodes[n].hash_ids = id_pool.size();
+        nodes[n].hash_count = build_hash_ids[n].size();
+        id_pool.insert(id_pool.end(), build_hash_ids[n].begin(), build_hash_ids[n].end());
+    }
+
+    // Load factor at most 1/2
+    uint32_t size = 8;
+    while (size < 2 * build_edges.size())
+        size <<= 1;
+
+    edges.assign(size, { 0, 0, 0, 0 });
+    edge_mask = size - 1;
+
+    for (const auto& e : build_edges)
+    {
+        const std::string& label = e.first.second;
+        uint32_t i = edge_hash(e.first.first, (const uint8_t*)label.data(), label.size()) & edge_mask;
+
+        while (edges[i].child)
+            i = (i + 1) & edge_mask;
+
+        edges[i] = { e.first.first, e.second, (uint32_t)labels.size(), (uint32_t)label.size() };
+        labels += label;
+    }
+
+    build_edges.clear();
+    build_ids.clear();
+    build_hash_ids.clear();
+    build_filters.clear();
+    compiled = true;
+}
+
+uint32_t MqttTopicTrie::child(uint32_t node, const uint8_t* level, unsigned len) const
+{
+    uint32_t i = edge_hash(node, level, len) & edge_mask;
+
+    while (edges[i].child)
+    {
+        const Edge& e = edges[i];
+        if (e.parent == node && e.label_len == len &&
+            !memcmp(labels.data() + e.label, level, len))
+            return e.child;
+        i = (i + 1) & edge_mask;
+    }
+    return 0;
+}
+
+// Each node sits at a fixed depth, so it is reached by at most one path
+// and the walk costs at most one visit per node, whatever the wildcards.
+// Report(first, count) is given runs of id_pool and returns true to stop.
+// When walking a filter, its wildcard levels are taken literally and only
+// the trie's own wildcards may match them.
+template<typename Report>
+void MqttTopicTrie::walk(const uint8_t* topic, unsigned len, bool filter, Report report) const
+{
+    if (!compiled)
+        return;
+
+    struct Step
+    {
+        uint32_t node;
+        unsigned pos;               // Start of the next level, len + 1 past the last
+    };
+
+    // Two branches per level at most ('+' and the literal edge)
+    static thread_local std::vector<Step> stack;
+    stack.clear();
+    stack.push_back({ ROOT, 0 });
+
+    bool system_topic = (len > 0 && topic[0] == '$');
+
+    while (!stack.empty())
+    {
+        Step s = stack.back();
+        stack.pop_back();
+
+        const Node& n = nodes[s.node];
+        bool wildcards = !(system_topic && s.node == ROOT);
+
+        if (wildcards && n.hash_count && report(n.hash_ids, n.hash_count))
+            return;
+
+        if (s.pos > len)
+        {
+            if (n.id_count && report(n.ids, n.id_count))
+                return;
+            continue;
+        }
+
+        const uint8_t* end = static_cast<const uint8_t*>(memchr(topic + s.pos, '/', len - s.pos));
+        unsigned level_len = end ? end - (topic + s.pos) : len - s.pos;
+        unsigned next = s.pos + level_len + 1;
+
+        // Nothing below a '#' node is as broad as the '#' itself
+        if (filter && level_len == 1 && topic[s.pos] == '#')
+            continue;
+
+        if (uint32_t c = child(s.node, topic + s.pos, level_len))
+            stack.push_back({ c, next });
+
+        if (wildcards && n.plus)
+            stack.push_back({ n.plus, next });
+    }
+}
+
+void MqttTopicTrie::match(const uint8_t* topic, unsigned len, uint32_t* stamps,
+    uint32_t generation) const
+{
+    walk(topic, len, false, [this, stamps, generation](uint32_t first, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+            stamps[id_pool[first + i]] = generation;
+        return false;
+    });
+}
+
+bool MqttTopicTrie::match_any(const uint8_t* topic, unsigned len) const
+{
+    bool found = false;
+
+    walk(topic, len, false, [&found](uint32_t, uint32_t)
+    {
+        found = true;
+        return true;
+    });
+
+    return found;
+}
+
+bool MqttTopicTrie::covers(const uint8_t* filter, unsigned len) const
+{
+    bool found = false;
+
+    walk(filter, len, true, [&found](uint32_t, uint32_t)
+    {
+        found = true;
+        return true;
+    });
+
+    return found;
+}
@@ -0,0 +1,109 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_topic_trie.h author Zhinoo Zobairi
+// Level trie matching a topic against many MQTT topic filters at once.
+
+#ifndef MQTT_TOPIC_TRIE_H
+#define MQTT_TOPIC_TRIE_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Filters are added while the configuration is read, then compile()
+// freezes the trie into flat arrays that packet threads share read-only.
+// One walk over the topic levels visits each trie node at most once and
+// reports every filter that matches, following MQTT 5.0 section 4.7:
+// '+' matches one level, a trailing '#' matches the parent level and
+// everything below it, and topics starting with '$' are not matched by
+// filters starting with a wildcard.
+class MqttTopicTrie
+{
+public:
+    MqttTopicTrie();
+
+    // '#' only as the whole last level, '+' only as a whole level
+    static bool valid_filter(const char* filter, unsigned len);
+
+    // Returns the filter's id; adding an identical filter returns the same id
+    unsigned add(const char* filter, unsigned len);
+
+    void compile();
+
+    bool is_compiled() const
+    { return compiled; }
+
+    unsigned size() const
+    { return filter_count; }
+
+    // Sets stamps[id] to generation for every filter matching the topic, so
+    // the caller tells this walk's matches from older ones without clearing
+    // stamps; it must hold size() entries
+    void match(const uint8_t* topic, unsigned len, uint32_t* stamps, uint32_t generation) const;
+
+    // True as soon as any filter matches
+    bool match_any(const uint8_t* topic, unsigned len) const;
+
+    // True when some filter matches every topic the given filter can match:
+    // a '+' level is only covered by '+' or '#', a '#' level only by '#'
+    bool covers(const uint8_t* filter, unsigned len) const;
+
+private:
+    struct Node
+    {
+        uint32_t plus;              // '+' child, 0 = none
+        uint32_t ids;               // Filters ending here, first index into id_pool
+        uint32_t id_count;
+        uint32_t hash_ids;          // Filters ending with '#' here
+        uint32_t hash_count;
+    };
+
+    struct Edge
+    {
+        uint32_t parent;
+        uint32_t child;             // 0 = empty slot, the root is never a child
+        uint32_t label;             // Offset into labels
+        uint32_t label_len;
+    };
+
+    // Build state, dropped by compile()
+    std::map<std::pair<uint32_t, std::string>, uint32_t> build_edges;
+    std::vector<std::vector<uint32_t>> build_ids;
+    std::vector<std::vector<uint32_t>> build_hash_ids;
+    std::map<std::string, unsigned> build_filters;
+
+    // Compiled state
+    std::vector<Node> nodes;
+    std::vector<Edge> edges;        // Open addressing, power of two
+    std::vector<uint32_t> id_pool;
+    std::string labels;
+    uint32_t edge_mask = 0;
+    unsigned filter_count = 0;
+    bool compiled = false;
+
+    uint32_t new_node();
+    uint32_t child(uint32_t node, const uint8_t* level, unsigned len) const;
+
+    template<typename Report>
+    void walk(const uint8_t* topic, unsigned len, bool filter, Report) const;
+};
+
+#endif
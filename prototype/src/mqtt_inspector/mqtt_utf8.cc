@@ -0,0 +1,119 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_utf8.cc author Zhinoo Zobairi
+// UTF-8 Encoded String validation (MQTT 5.0 section 1.5.4).
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mqtt_utf8.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Validates the sequence starting with the non-ASCII or NUL byte at pos
+// and moves pos past it
+static bool valid_sequence(const uint8_t* str, unsigned len, unsigned& pos)
+{
+    uint8_t c = str[pos];
+
+    if (c == 0)
+        return false;
+
+    if (c < 0x80)
+    {
+        pos++;
+        return true;
+    }
+
+    unsigned n;
+    uint8_t lo = 0x80, hi = 0xBF;   // Range of the second byte
+
+    if (c >= 0xC2 && c <= 0xDF)
+        n = 1;
+    else if (c >= 0xE0 && c <= 0xEF)
+    {
+        n = 2;
+        if (c == 0xE0)
+            lo = 0xA0;              // Overlong
+        else if (c == 0xED)
+            hi = 0x9F;              // Surrogates
+    }
+    else if (c >= 0xF0 && c <= 0xF4)
+    {
+        n = 3;
+        if (c == 0xF0)
+            lo = 0x90;              // Overlong
+        else if (c == 0xF4)
+            hi = 0x8F;              // Above U+10FFFF
+    }
+    else
+        return false;               // Continuation byte, C0, C1 or F5-FF
+
+    if (len - pos <= n)
+        return false;
+
+    if (str[pos + 1] < lo || str[pos + 1] > hi)
+        return false;
+
+    for (unsigned i = 2; i <= n; i++)
+    {
+        if ((str[pos + i] & 0xC0) != 0x80)
+            return false;
+    }
+
+    pos += n + 1;
+    return true;
+}
+
+bool mqtt_valid_utf8(const uint8_t* str, unsigned len)
+{
+    unsigned pos = 0;
+
+    while (pos < len)
+    {
+#ifdef __SSE2__
+        // Skip whole blocks of ASCII without NUL
+        const __m128i zero = _mm_setzero_si128();
+
+        while (pos + 16 <= len)
+        {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + pos));
+            unsigned mask = _mm_movemask_epi8(chunk) |
+                _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, zero));
+
+            if (mask)
+            {
+                pos += __builtin_ctz(mask);
+                break;
+            }
+            pos += 16;
+        }
+
+        if (pos >= len)
+            break;
+#endif
+
+        if (!valid_sequence(str, len, pos))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2025 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mqtt_utf8.h author Zhinoo Zobairi
+// UTF-8 Encoded String validation (MQTT 5.0 section 1.5.4).
+
+#ifndef MQTT_UTF8_H
+#define MQTT_UTF8_H
+
+#include <cstdint>
+
+// True when str is well-formed UTF-8 (RFC 3629: no overlong forms, no
+// surrogates, nothing above U+10FFFF) and holds no U+0000. ASCII runs are
+// checked 16 bytes at a time, multi-byte sequences one by one.
+bool mqtt_valid_utf8(const uint8_t* str, unsigned len);
+
+#endif